@@ -0,0 +1,42 @@
+/**
+ * @file compiler/shift_arena.cpp
+ */
+
+#include "compiler/shift_arena.h"
+
+#include <algorithm>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		void* arena::m_allocate_chunk(const std::size_t size) {
+			const std::size_t bytes = std::max(size, chunk_size);
+			this->m_chunks.emplace_back(new std::max_align_t[(bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]);
+			this->m_capacity += bytes;
+
+			char* const chunk = reinterpret_cast<char*>(this->m_chunks.back().get());
+			if (size >= chunk_size) // an oversized object; keep bumping through the current chunk
+				return chunk;
+
+			this->m_next = chunk + size;
+			this->m_end = chunk + bytes;
+			return chunk;
+		}
+
+		void arena::clear(void) noexcept {
+			this->m_chunks.clear();
+			this->m_next = this->m_end = nullptr;
+			this->m_capacity = 0;
+		}
+
+		void arena::merge(arena& other) {
+			// the chunk being bumped through stays this one's
+			this->m_chunks.reserve(this->m_chunks.size() + other.m_chunks.size());
+			for (std::unique_ptr<std::max_align_t[]>& chunk : other.m_chunks)
+				this->m_chunks.push_back(std::move(chunk));
+			this->m_capacity += other.m_capacity;
+			other.clear();
+		}
+	}
+}
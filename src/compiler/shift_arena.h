@@ -0,0 +1,225 @@
+/**
+ * @file compiler/shift_arena.h
+ *
+ * Bump allocation of syntax tree nodes, and the node lists built on it
+ */
+#ifndef SHIFT_ARENA_H_
+#define SHIFT_ARENA_H_ 1
+
+#include "shift_config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/**
+		 * Memory for the nodes of one syntax tree.
+		 *
+		 * Objects are carved out of large chunks one after the other and are never freed on their own; the chunks are all
+		 * freed at once with the arena. Objects are not destroyed either, so only trivially destructible types may be
+		 * allocated. Objects never move, so pointers to them stay valid for as long as the arena lives, even if the arena
+		 * itself is moved.
+		 */
+		class arena {
+		public:
+			/// Size of the chunks objects are allocated from; larger objects get a chunk of their own
+			static constexpr std::size_t chunk_size = std::size_t(64) << 10;
+		public:
+			arena(void) = default;
+			arena(const arena&) = delete;
+			arena(arena&&) noexcept = default;
+			~arena() noexcept = default;
+
+			arena& operator=(const arena&) = delete;
+			arena& operator=(arena&&) noexcept = default;
+
+			/// Allocates @a size bytes aligned to @a alignment, which must be a power of two no greater than alignof(std::max_align_t)
+			inline void* allocate(const std::size_t size, const std::size_t alignment) {
+				const std::uintptr_t next = (reinterpret_cast<std::uintptr_t>(this->m_next) + (alignment - 1)) & ~std::uintptr_t(alignment - 1);
+				if (!this->m_next || next + size > reinterpret_cast<std::uintptr_t>(this->m_end))
+					return this->m_allocate_chunk(size);
+
+				this->m_next = reinterpret_cast<char*>(next + size);
+				return reinterpret_cast<void*>(next);
+			}
+
+			/// Constructs an object in the arena
+			template<typename T, typename... Args>
+			inline T* create(Args&&... args) {
+				static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+				static_assert(alignof(T) <= alignof(std::max_align_t), "arena objects can not be over-aligned");
+				return ::new (this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			}
+
+			/// Number of bytes held by the arena, including the unused end of its chunks
+			inline std::size_t capacity(void) const noexcept { return this->m_capacity; }
+
+			/// Frees every object of the arena at once
+			void clear(void) noexcept;
+
+			/// Takes over the objects of @a other, which is left empty; the objects do not move, so pointers to them stay valid
+			void merge(arena& other);
+		private:
+			void* m_allocate_chunk(std::size_t size);
+		private:
+			std::vector<std::unique_ptr<std::max_align_t[]>> m_chunks;
+			char* m_next = nullptr, * m_end = nullptr;
+			std::size_t m_capacity = 0;
+		};
+
+		/**
+		 * Doubly linked list whose nodes live in an arena.
+		 *
+		 * The list only holds the ends of the chain, so it is trivially destructible itself and may be an element of another
+		 * arena list; the arena to allocate from is passed to every insertion. Removing elements does not free them. Like
+		 * std::list, moving a list leaves the source empty and never moves the elements, and lists can not be copied.
+		 */
+		template<typename T>
+		class arena_list {
+		private:
+			struct node {
+				T value;
+				node* prev = nullptr, * next = nullptr;
+			};
+
+			template<typename V, typename N>
+			class basic_iterator {
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = V*;
+				using reference = V&;
+			public:
+				constexpr basic_iterator(void) noexcept = default;
+				constexpr explicit basic_iterator(N* const node) noexcept: m_node(node) {}
+
+				/// Iterators convert to const iterators
+				template<typename V2, typename N2, typename = std::enable_if_t<std::is_const_v<V> && !std::is_same_v<V, V2>>>
+				constexpr basic_iterator(const basic_iterator<V2, N2>& other) noexcept: m_node(other.m_node) {}
+
+				inline reference operator*(void) const noexcept { return this->m_node->value; }
+				inline pointer operator->(void) const noexcept { return &this->m_node->value; }
+
+				inline basic_iterator& operator++(void) noexcept { this->m_node = this->m_node->next; return *this; }
+				inline basic_iterator operator++(int) noexcept { const basic_iterator it = *this; this->m_node = this->m_node->next; return it; }
+
+				constexpr bool operator==(const basic_iterator& other) const noexcept { return this->m_node == other.m_node; }
+				constexpr bool operator!=(const basic_iterator& other) const noexcept { return this->m_node != other.m_node; }
+			private:
+				template<typename, typename> friend class basic_iterator;
+				N* m_node = nullptr;
+			};
+		public:
+			using value_type = T;
+			using size_type = std::uint32_t;
+			using iterator = basic_iterator<T, node>;
+			using const_iterator = basic_iterator<const T, const node>;
+		public:
+			constexpr arena_list(void) noexcept = default;
+			arena_list(const arena_list&) = delete;
+			constexpr arena_list(arena_list&& other) noexcept: m_head(other.m_head), m_tail(other.m_tail), m_size(other.m_size) { other.m_head = other.m_tail = nullptr; other.m_size = 0; }
+			~arena_list() noexcept = default;
+
+			arena_list& operator=(const arena_list&) = delete;
+
+			inline arena_list& operator=(arena_list&& other) noexcept {
+				if (this != &other) {
+					this->m_head = other.m_head;
+					this->m_tail = other.m_tail;
+					this->m_size = other.m_size;
+					other.m_head = other.m_tail = nullptr;
+					other.m_size = 0;
+				}
+				return *this;
+			}
+
+			inline iterator begin(void) noexcept { return iterator(this->m_head); }
+			inline iterator end(void) noexcept { return iterator(); }
+			inline const_iterator begin(void) const noexcept { return const_iterator(this->m_head); }
+			inline const_iterator end(void) const noexcept { return const_iterator(); }
+			inline const_iterator cbegin(void) const noexcept { return const_iterator(this->m_head); }
+			inline const_iterator cend(void) const noexcept { return const_iterator(); }
+
+			/// Number of bytes an element takes in the arena
+			static constexpr std::size_t node_size(void) noexcept { return sizeof(node); }
+
+			constexpr size_type size(void) const noexcept { return this->m_size; }
+			constexpr bool empty(void) const noexcept { return this->m_size == 0; }
+
+			inline T& front(void) noexcept { return this->m_head->value; }
+			inline const T& front(void) const noexcept { return this->m_head->value; }
+			inline T& back(void) noexcept { return this->m_tail->value; }
+			inline const T& back(void) const noexcept { return this->m_tail->value; }
+
+			/// Appends an element constructed from @a args in @a arena
+			template<typename... Args>
+			inline T& emplace_back(arena& arena, Args&&... args) {
+				node* const n = arena.create<node>(node { T(std::forward<Args>(args)...), this->m_tail, nullptr });
+				(this->m_tail ? this->m_tail->next : this->m_head) = n;
+				this->m_tail = n;
+				this->m_size++;
+				return n->value;
+			}
+
+			inline T& push_back(arena& arena, T&& value) { return this->emplace_back(arena, std::move(value)); }
+
+			/// Moves the last element of @a other to the back of this list, without moving the element itself
+			inline void splice_back(arena_list& other) noexcept {
+				node* const n = other.m_tail;
+				other.pop_back();
+
+				n->prev = this->m_tail;
+				n->next = nullptr;
+				(this->m_tail ? this->m_tail->next : this->m_head) = n;
+				this->m_tail = n;
+				this->m_size++;
+			}
+
+			/// Moves every element of @a other to the back of this list, without moving the elements themselves
+			inline void splice_back_all(arena_list& other) noexcept {
+				if (other.empty())
+					return;
+
+				other.m_head->prev = this->m_tail;
+				(this->m_tail ? this->m_tail->next : this->m_head) = other.m_head;
+				this->m_tail = other.m_tail;
+				this->m_size += other.m_size;
+				other.clear();
+			}
+
+			inline void pop_back(void) noexcept {
+				this->m_tail = this->m_tail->prev;
+				(this->m_tail ? this->m_tail->next : this->m_head) = nullptr;
+				this->m_size--;
+			}
+
+			/// Appends default-constructed elements or removes elements from the back, until the list holds @a count of them
+			inline void resize(arena& arena, const size_type count) {
+				while (this->m_size > count)
+					this->pop_back();
+				while (this->m_size < count)
+					this->emplace_back(arena);
+			}
+
+			inline void clear(void) noexcept {
+				this->m_head = this->m_tail = nullptr;
+				this->m_size = 0;
+			}
+		private:
+			node* m_head = nullptr, * m_tail = nullptr;
+			size_type m_size = 0;
+		};
+	}
+}
+
+#endif /* SHIFT_ARENA_H_ */
@@ -7,6 +7,7 @@
 #include <stdexcept>
 #include <cstring>
 #include <algorithm>
+#include <charconv>
 
 #define SHIFT_WARNING_PREFIX 			"warning: "
 #define SHIFT_ERROR_PREFIX 				"error: "	
@@ -82,6 +83,78 @@ namespace shift {
 				} else if (arg == SHIFT_FLAG_NO_STD_LIB) {
 					// The user requested to not link against the Shift standard library
 					this->m_flags |= FLAG_NO_STD;
+				} else if (arg == SHIFT_FLAG_TOKEN_CACHE) {
+					// The user requested for tokens to be cached across compilations
+					this->m_flags |= FLAG_TOKEN_CACHE;
+				} else if (arg == SHIFT_FLAG_PARSE_STATS) {
+					// The user requested for the size of the syntax trees to be reported
+					this->m_flags |= FLAG_PARSE_STATS;
+				} else if (arg == SHIFT_FLAG_EMIT_MODULE) {
+					// The user requested for the declarations of every source file to be written to a module file
+					this->m_flags |= FLAG_EMIT_MODULE;
+				} else if (arg == SHIFT_FLAG_DIAGNOSTICS_STREAM) {
+					// The user requested for the messages of every source file to be printed as soon as they are known
+					this->m_flags |= FLAG_DIAGNOSTICS_STREAM;
+				} else if (utils::starts_with(arg, std::string_view(SHIFT_FLAG_JOBS))) {
+					// The user requested for source files to be compiled on a number of threads
+					std::string_view count = arg.substr(std::string_view(SHIFT_FLAG_JOBS).length());
+					const bool separate = count.empty(); // "-j 4" rather than "-j4"
+					if (separate && (i + 1) < this->m_args.size())
+						count = this->m_args[i + 1];
+
+					size_t jobs = 0;
+					const auto [end, status] = std::from_chars(count.data(), count.data() + count.length(), jobs);
+					if (count.empty() || status != std::errc() || end != count.data() + count.length() || jobs == 0) {
+						if (this->m_error_handler) {
+							SHIFT_ERROR("Expected number of threads after flag " << SHIFT_FLAG_JOBS << " (parameter " << (i + 1) << ")");
+						}
+						std::string out;
+						out.reserve(off + arg.size());
+						out.append(off, ' ');
+						out.append(arg.size(), '^');
+
+						if (this->m_error_handler) {
+							SHIFT_ERROR_LOG(this->to_string());
+							SHIFT_ERROR_LOG(out);
+						}
+					} else {
+						this->m_jobs = jobs;
+						if (separate) {
+							off += arg.length() + 1; // + 1 to account for space character when printing out
+							i++;
+						}
+					}
+				} else if (utils::starts_with(arg, std::string_view(SHIFT_FLAG_MAX_ERRORS))) {
+					// The user requested for compilation to stop once a number of errors were found, 0 for no limit
+					std::string_view count = arg.substr(std::string_view(SHIFT_FLAG_MAX_ERRORS).length());
+					const bool separate = count.empty(); // "-max-errors 10" rather than "-max-errors=10"
+					if (separate && (i + 1) < this->m_args.size())
+						count = this->m_args[i + 1];
+					else if (!separate)
+						count = count.front() == '=' ? count.substr(1) : std::string_view();
+
+					size_t max_errors = 0;
+					const auto [end, status] = std::from_chars(count.data(), count.data() + count.length(), max_errors);
+					if (count.empty() || status != std::errc() || end != count.data() + count.length()) {
+						if (this->m_error_handler) {
+							SHIFT_ERROR("Expected number of errors after flag " << SHIFT_FLAG_MAX_ERRORS << " (parameter " << (i + 1) << ")");
+						}
+						std::string out;
+						out.reserve(off + arg.size());
+						out.append(off, ' ');
+						out.append(arg.size(), '^');
+
+						if (this->m_error_handler) {
+							SHIFT_ERROR_LOG(this->to_string());
+							SHIFT_ERROR_LOG(out);
+						}
+					} else {
+						this->m_max_errors = max_errors;
+						if (separate) {
+							off += arg.length() + 1; // + 1 to account for space character when printing out
+							i++;
+						}
+					}
 				} else if (arg == SHIFT_FLAG_LIB_PATH) {
 					if ((i + 1) >= this->m_args.size()) {
 						if (this->m_error_handler) {
@@ -145,7 +218,13 @@ namespace shift {
 			}
 
 			// Ensures library and source files exist
-			return this->resolve_libraries_and_sources();
+			this->resolve_libraries_and_sources();
+
+			// Only set now, so that none of the messages about the arguments are cut short by the limit
+			if (this->m_max_errors != 0 && this->m_error_handler)
+				this->m_error_handler->set_max_errors(this->m_max_errors);
+			if (this->is_diagnostics_stream() && this->m_error_handler)
+				this->m_error_handler->set_print_immediately();
 		}
 
 		void argument_parser::resolve_libraries_and_sources(void) {
@@ -28,6 +28,12 @@
 #define SHIFT_FLAG_LIB 					SHIFT_FLAG("lib")
 #define SHIFT_FLAG_HELP					SHIFT_FLAG("help")
 #define SHIFT_FLAG_NO_STD_LIB 			SHIFT_FLAG("no-std") // Not yet implemented
+#define SHIFT_FLAG_TOKEN_CACHE 			SHIFT_FLAG("token-cache")
+#define SHIFT_FLAG_PARSE_STATS 			SHIFT_FLAG("parse-stats")
+#define SHIFT_FLAG_EMIT_MODULE 			SHIFT_FLAG("emit-module")
+#define SHIFT_FLAG_DIAGNOSTICS_STREAM 	SHIFT_FLAG("diagnostics-stream")
+#define SHIFT_FLAG_JOBS 				SHIFT_FLAG("j") // followed by the number of threads, either as the next parameter or right after the flag
+#define SHIFT_FLAG_MAX_ERRORS 			SHIFT_FLAG("max-errors") // followed by the number of errors, either as the next parameter or after an '='
 
 namespace shift {
 	namespace compiler {
@@ -66,6 +72,30 @@ namespace shift {
 					*/
 					FLAG_HELP = 0x10, /**< FLAG_HELP */
 
+					/**
+					 * Tells the compiler to keep the tokens of every source file in an on-disk cache, and to load the tokens
+					 * of unchanged files from it rather than lexing them again.
+					 */
+					FLAG_TOKEN_CACHE = 0x20, /**< FLAG_TOKEN_CACHE */
+
+					/**
+					 * Tells the compiler to report the number of statements of every source file, and how much memory their
+					 * syntax trees take.
+					 */
+					FLAG_PARSE_STATS = 0x40, /**< FLAG_PARSE_STATS */
+
+					/**
+					 * Tells the compiler to write the declarations of every source file to a binary module file next to it,
+					 * which can be loaded in place of the source when it is imported.
+					 */
+					FLAG_EMIT_MODULE = 0x80, /**< FLAG_EMIT_MODULE */
+
+					/**
+					 * Tells the compiler to print the messages of every source file as soon as the file, and every file before
+					 * it, has been worked through, rather than once all of them have.
+					 */
+					FLAG_DIAGNOSTICS_STREAM = 0x100, /**< FLAG_DIAGNOSTICS_STREAM */
+
 					/**
 					 * Indicates a value of no flags.
 					 * This is usually never used, as FLAG_HELP is used whenever a user passes in no parameters.
@@ -143,11 +173,21 @@ namespace shift {
 			inline const std::list<filesystem::directory>& get_library_paths(void) const noexcept { return this->m_library_paths; }
 			inline const std::list<filesystem::file>& get_libraries(void) const noexcept { return this->m_libraries; }
 
+			/// Number of threads the user requested to compile on, or 0 if the user left it to the compiler
+			inline size_t get_jobs(void) const noexcept { return this->m_jobs; }
+
+			/// Number of errors after which compilation stops, or 0 for no limit
+			inline size_t get_max_errors(void) const noexcept { return this->m_max_errors; }
+
 			inline bool is_warnings(void) const noexcept { return this->has_flag(FLAG_WARNINGS); }
 			inline bool is_werrors(void) const noexcept { return this->has_flag(FLAG_WERROR); }
 			inline bool is_cpp_out(void) const noexcept { return this->has_flag(FLAG_CPP_OUTPUT); }
 			inline bool is_help(void) const noexcept { return this->has_flag(FLAG_HELP); }
 			inline bool is_no_std(void) const noexcept { return this->has_flag(FLAG_NO_STD); }
+			inline bool is_token_cache(void) const noexcept { return this->has_flag(FLAG_TOKEN_CACHE); }
+			inline bool is_parse_stats(void) const noexcept { return this->has_flag(FLAG_PARSE_STATS); }
+			inline bool is_emit_module(void) const noexcept { return this->has_flag(FLAG_EMIT_MODULE); }
+			inline bool is_diagnostics_stream(void) const noexcept { return this->has_flag(FLAG_DIAGNOSTICS_STREAM); }
 			inline bool has_flag(flags const flag) const noexcept { return (this->m_flags & flag) == flag; }
 
 			inline error_handler* get_error_handler() noexcept { return m_error_handler; }
@@ -166,6 +206,12 @@ namespace shift {
 			/// Sources files, library paths, and library files
 			std::list<filesystem::file> m_compile_files, m_libraries;
 			std::list<filesystem::directory> m_library_paths;
+
+			/// Number of threads to compile on, 0 if not given
+			size_t m_jobs = 0;
+
+			/// Number of errors to stop compiling after, 0 if not given
+			size_t m_max_errors = 0;
 		private:
 			void resolve_libraries_and_sources(void);
 		};
@@ -1,31 +1,153 @@
 #include "compiler/shift_compiler.h"
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
 namespace shift {
     namespace compiler {
+        namespace {
+            /**
+             * Moves the messages of every file into the compiler's handler in the order of the files, each as soon as the file
+             * and every file before it are done. Files report into handlers of their own, so only finishing a file takes the
+             * lock; with -diagnostics-stream, the compiler's handler prints what it is given right away, so the messages of a
+             * file come out while later files are still being worked through.
+             */
+            class file_merge {
+            public:
+                file_merge(error_handler& target, std::vector<error_handler>& errors): m_target(target), m_errors(errors),
+                    m_done(errors.size()), m_failed(errors.size()) {}
+
+                void finish(const size_t index) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done[index] = true;
+                    for (; m_next < m_done.size() && m_done[m_next]; m_next++) {
+                        m_failed[m_next] = m_errors[m_next].get_error_count() != 0;
+                        m_target.append(m_errors[m_next]);
+                    }
+                }
+
+                /// Whether the file at @a index reported errors; only known once every file is done
+                inline bool is_failed(const size_t index) const noexcept { return m_failed[index]; }
+            private:
+                error_handler& m_target;
+                std::vector<error_handler>& m_errors;
+                std::vector<char> m_done, m_failed;
+                size_t m_next = 0; // first file not yet moved
+                std::mutex m_mutex;
+            };
+        }
+
+        thread_pool& compiler::m_get_thread_pool() {
+            if (!m_thread_pool)
+                m_thread_pool = std::make_unique<thread_pool>(m_args.get_jobs());
+            return *m_thread_pool;
+        }
+
+        error_handler compiler::m_file_error_handler() const {
+            return m_error_handler.branch();
+        }
+
         void compiler::tokenize() {
-            for (filesystem::file const& file : m_args.get_source_files()) {
-                const auto error_count_begin = m_error_handler.get_error_count();
+            if (m_error_handler.is_error_limit_reached())
+                return;
+
+            if (m_args.is_token_cache() && !m_token_cache)
+                m_token_cache = std::make_unique<token_cache>();
+
+            thread_pool& pool = m_get_thread_pool();
+            const std::list<filesystem::file>& files = m_args.get_source_files();
+
+            // every file reports into a handler of its own, so that the output does not depend on which file finished first (see file_merge)
+            std::vector<error_handler> errors;
+            std::list<tokenizer> tokenizers;
+            std::vector<tokenizer*> jobs;
+            errors.reserve(files.size());
+            jobs.reserve(files.size());
 
-                tokenizer _tokenizer(&m_error_handler, file);
-                _tokenizer.tokenize();
+            for (filesystem::file const& file : files) {
+                errors.push_back(m_file_error_handler());
 
-                const auto error_count_end = m_error_handler.get_error_count();
+                tokenizer& _tokenizer = tokenizers.emplace_back(&errors.back(), file);
+                _tokenizer.set_cache(m_token_cache.get());
+                _tokenizer.set_threads(std::max<size_t>(pool.get_threads() / files.size(), 1)); // the threads left over split large files
+                jobs.push_back(&_tokenizer);
+            }
+
+            file_merge merge(m_error_handler, errors);
+            pool.run(jobs.size(), [&jobs, &merge](const size_t index) {
+                jobs[index]->tokenize();
+                merge.finish(index);
+            });
 
-                if (error_count_begin == error_count_end)
-                    m_tokenizers.push_back(std::move(_tokenizer));
+            auto _tokenizer = tokenizers.begin();
+            for (size_t index = 0; index < errors.size(); index++) {
+                const auto next = std::next(_tokenizer);
+                if (!merge.is_failed(index)) {
+                    _tokenizer->set_error_handler(&m_error_handler);
+                    m_tokenizers.splice(m_tokenizers.end(), tokenizers, _tokenizer);
+                }
+                _tokenizer = next;
             }
         }
 
         void compiler::parse() {
+            if (m_error_handler.is_error_limit_reached())
+                return;
+
+            thread_pool& pool = m_get_thread_pool();
+
+            // see tokenize()
+            std::vector<error_handler> errors;
+            std::list<parser> parsers;
+            std::vector<parser*> jobs;
+            errors.reserve(m_tokenizers.size());
+            jobs.reserve(m_tokenizers.size());
+
             for (tokenizer& _tokenizer : m_tokenizers) {
-                const auto error_count_begin = m_error_handler.get_error_count();
+                errors.push_back(m_file_error_handler());
+                jobs.push_back(&parsers.emplace_back(&errors.back(), &_tokenizer));
+                jobs.back()->set_threads(std::max<size_t>(pool.get_threads() / m_tokenizers.size(), 1)); // as in tokenize()
+            }
 
-                parser _parser(&m_error_handler, &_tokenizer);
+            file_merge merge(m_error_handler, errors);
+            pool.run(jobs.size(), [this, &jobs, &merge](const size_t index) {
+                parser& _parser = *jobs[index];
                 _parser.parse();
 
-                const auto error_count_end = m_error_handler.get_error_count();
-                if (error_count_begin == error_count_end)
-                    m_parsers.push_back(std::move(_parser));
+                if (m_args.is_parse_stats()) {
+                    error_handler& file_errors = *_parser.get_error_handler();
+                    file_errors.stream() << "info: " << std::filesystem::relative(_parser.get_tokenizer()->get_file().raw_path()).string() << ": "
+                        << _parser.get_statement_count() << " statements of " << parser::get_statement_size() << " bytes, "
+                        << _parser.get_tree_size() << " bytes of syntax tree\n";
+                    file_errors.flush_stream(error_handler::message_type::info);
+                }
+                merge.finish(index);
+            });
+
+            auto _parser = parsers.begin();
+            for (size_t index = 0; index < errors.size(); index++) {
+                const auto next = std::next(_parser);
+                if (!merge.is_failed(index)) {
+                    _parser->set_error_handler(&m_error_handler);
+                    m_parsers.splice(m_parsers.end(), parsers, _parser);
+                }
+                _parser = next;
+            }
+        }
+
+        void compiler::emit_modules() {
+            if (!m_args.is_emit_module() || m_error_handler.is_error_limit_reached())
+                return;
+
+            for (const parser& _parser : m_parsers) {
+                std::filesystem::path path = _parser.get_tokenizer()->get_file().raw_path();
+                path.replace_extension(module_file::extension);
+
+                if (!module_file::store(_parser, path)) {
+                    m_error_handler.stream() << "error: could not write module file " << std::filesystem::relative(path).string() << '\n';
+                    m_error_handler.flush_stream(error_handler::message_type::error);
+                }
             }
         }
     }
@@ -4,7 +4,10 @@
 #include "compiler/shift_error_handler.h"
 #include "compiler/shift_argument_parser.h"
 #include "compiler/shift_tokenizer.h"
+#include "compiler/shift_token_cache.h"
 #include "compiler/shift_parser.h"
+#include "compiler/shift_module_file.h"
+#include "compiler/shift_thread_pool.h"
 
 namespace shift {
     namespace compiler {
@@ -16,16 +19,32 @@ namespace shift {
             inline compiler(std::vector<std::string_view>&& args) noexcept;
 
             inline void parse_flags() { m_args.parse(); }
+
+            /**
+             * Lexes every source file; the files are lexed concurrently, but report their diagnostics in command-line order,
+             * those of a file as soon as it and every file before it are lexed (printed right away with -diagnostics-stream).
+             * Like every later phase, this does nothing once the error limit (-max-errors) has been reached.
+             */
             void tokenize();
+
+            /// Parses every source file that lexed without errors; like tokenize(), files are parsed concurrently
             void parse();
 
+            /// Writes the module file of every source file that parsed without errors, if requested with -emit-module
+            void emit_modules();
+
             inline error_handler& get_error_handler() noexcept { return m_error_handler; }
             inline error_handler const& get_error_handler() const noexcept { return m_error_handler; }
+        private:
+            thread_pool& m_get_thread_pool();
+            error_handler m_file_error_handler() const;
         private:
             error_handler m_error_handler;
             argument_parser m_args;
+            std::unique_ptr<token_cache> m_token_cache;
             std::list<tokenizer> m_tokenizers;
             std::list<parser> m_parsers;
+            std::unique_ptr<thread_pool> m_thread_pool; // created on first use, with as many threads as the user requested
         };
 
         inline compiler::compiler() noexcept: m_args(&m_error_handler) {}
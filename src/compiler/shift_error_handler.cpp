@@ -2,6 +2,7 @@
  * @file compiler/error_handler.cpp
  */
 #include "shift_error_handler.h"
+#include "compiler/shift_source_map.h"
 
 #include "logging/console.h"
 
@@ -14,118 +15,274 @@ namespace shift {
 	namespace compiler {
 		error_handler& error_handler::operator=(const error_handler& other) noexcept {
 			this->m_messages = other.m_messages;
-			this->m_message_stream.str(other.m_message_stream.str());
+			if (other.m_message_stream)
+				this->stream().str(other.m_message_stream->str());
+			else if (this->m_message_stream)
+				this->m_message_stream->str("");
 			this->m_marks = other.m_marks;
+			this->m_error_count = other.m_error_count;
+			this->m_warning_count = other.m_warning_count;
+			this->m_max_errors = other.m_max_errors;
+			this->m_errors_before = other.m_errors_before;
 			return *this;
 		}
 
+		namespace {
+			void print_message(const error_handler::message& message, const bool color, std::ostream& out_stream, std::ostream& err_stream) {
+				using message_type = error_handler::message_type;
+
+				const message_type type = message.type;
+				if (type == message_type::error) {
+					if (color && logging::has_colored_console()) {
+						message.write(err_stream << logging::lred);
+						err_stream << logging::creset;
+					} else {
+						message.write(err_stream);
+					}
+				} else if (type == message_type::warning) {
+					if (color && logging::has_colored_console()) {
+						message.write(out_stream << logging::lyellow);
+						out_stream << logging::creset;
+					} else {
+						message.write(out_stream);
+					}
+				} else if (type == message_type::info) {
+					if (color && logging::has_colored_console()) {
+						message.write(out_stream << logging::lblue);
+						out_stream << logging::creset;
+					} else {
+						message.write(out_stream);
+					}
+				} else {
+					message.write(out_stream);
+				}
+			}
+		}
+
+		bool error_handler::m_add(message&& msg) {
+			if (this->is_error_limit_reached())
+				return false;
+
+			if (msg.type == message_type::error)
+				this->m_error_count++;
+			else if (msg.type == message_type::warning)
+				this->m_warning_count++;
+
+			if (this->m_print_immediately)
+				print_message(msg, true, std::cout, std::cerr);
+			else
+				this->m_messages.push_back(std::move(msg));
+			return true;
+		}
+
 		error_handler& error_handler::add_info(const std::string& info) noexcept {
 			if (!this->m_warnings)
 				return *this;
-			this->m_messages.push_back(_message_pair_type(info, message_type::info));
+			this->m_add(message(info, message_type::info));
 			return *this;
 		}
 
 		error_handler& error_handler::add_warning(const std::string& warning) noexcept {
 			if (!this->m_warnings)
 				return *this;
-			this->m_messages.push_back(_message_pair_type(warning, this->m_werror ? message_type::error : message_type::warning));
+			this->m_add(message(warning, this->m_werror ? message_type::error : message_type::warning));
 			return *this;
 		}
 
 		error_handler& error_handler::add_error(const std::string& error) noexcept {
-			this->m_messages.push_back(_message_pair_type(error, message_type::error));
+			this->m_add(message(error, message_type::error));
 			return *this;
 		}
 
 		error_handler& error_handler::add_info(std::string&& info) noexcept {
 			if (!this->m_warnings)
 				return *this;
-			this->m_messages.push_back(_message_pair_type(std::move(info), message_type::info));
+			this->m_add(message(std::move(info), message_type::info));
 			return *this;
 		}
 
 		error_handler& error_handler::add_warning(std::string&& warning) noexcept {
 			if (!this->m_warnings)
 				return *this;
-			this->m_messages.push_back(_message_pair_type(std::move(warning), this->m_werror ? message_type::error : message_type::warning));
+			this->m_add(message(std::move(warning), this->m_werror ? message_type::error : message_type::warning));
 			return *this;
 		}
 
 		error_handler& error_handler::add_error(std::string&& error) noexcept {
-			this->m_messages.push_back(_message_pair_type(std::move(error), message_type::error));
+			this->m_add(message(std::move(error), message_type::error));
+			return *this;
+		}
+
+		error_handler& error_handler::add_diagnostic(message_type type, const std::shared_ptr<const source_file>& file, const std::uint32_t line, const std::uint32_t col,
+			const std::uint32_t length, const char* const format, const std::string_view first, const std::string_view second) {
+			if (type != message_type::error && !this->m_warnings)
+				return *this;
+
+			if (this->is_error_limit_reached())
+				return *this;
+
+			message added;
+			added.type = type == message_type::warning && this->m_werror ? message_type::error : type;
+			added.severity = type;
+			added.file = file;
+			added.format = format;
+			added.line = line;
+			added.col = col;
+			added.length = length;
+			added.split = static_cast<std::uint32_t>(first.size());
+			added.text.reserve(first.size() + second.size());
+			added.text.append(first).append(second);
+			this->m_add(std::move(added));
+			return *this;
+		}
+
+		error_handler& error_handler::add_message(message msg) {
+			this->m_add(std::move(msg));
 			return *this;
 		}
 
+		error_handler error_handler::branch(void) const {
+			error_handler branch;
+			branch.m_warnings = this->m_warnings;
+			branch.m_werror = this->m_werror;
+			branch.m_max_errors = this->m_max_errors;
+			branch.m_errors_before = this->m_errors_before + this->m_error_count;
+			return branch;
+		}
+
+		void error_handler::insert(const std::vector<std::pair<size_t, error_handler*>>& others) {
+			// put together again in one pass, rather than moving what follows each position along every time
+			std::vector<message> messages;
+			messages.swap(this->m_messages);
+			size_t total = messages.size();
+			for (const auto& [position, other] : others)
+				total += other->m_messages.size();
+			this->m_messages.reserve(total);
+			if (!this->m_print_immediately) // otherwise, the messages counted are already printed, and held no more
+				this->m_error_count = this->m_warning_count = 0;
+
+			size_t next = 0;
+			for (const auto& [position, other] : others) {
+				for (; next < position && next < messages.size(); next++)
+					this->m_add(std::move(messages[next]));
+				for (message& msg : other->m_messages)
+					this->m_add(std::move(msg));
+				other->clear();
+			}
+			for (; next < messages.size(); next++)
+				this->m_add(std::move(messages[next]));
+
+			if (this->m_print_immediately) {
+				std::cerr.flush();
+				std::cout.flush();
+			}
+		}
+
+		void error_handler::set_print_immediately(const bool immediately) {
+			if (immediately && !this->m_print_immediately) {
+				this->print();
+				this->m_messages.clear();
+			}
+			this->m_print_immediately = immediately;
+		}
+
+		std::ostringstream& error_handler::stream(void) {
+			if (!this->m_message_stream)
+				this->m_message_stream = std::make_unique<std::ostringstream>();
+			return *this->m_message_stream;
+		}
+
+		void error_handler::format(void) {
+			for (message& message : this->m_messages) {
+				if (message.is_diagnostic()) {
+					message.text = message.get_text();
+					message.file = nullptr;
+					message.format = nullptr;
+				}
+			}
+		}
+
+		std::string error_handler::message::get_text(void) const {
+			if (!this->is_diagnostic())
+				return this->text;
+
+			std::ostringstream out;
+			this->write(out);
+			return out.str();
+		}
+
+		void error_handler::message::write(std::ostream& out) const {
+			if (!this->is_diagnostic()) {
+				out << this->text;
+				return;
+			}
+
+			if (this->file->relative.empty())
+				this->file->relative = std::filesystem::relative(this->file->path).string();
+
+			out << (this->severity == message_type::error ? "error: " : this->severity == message_type::warning ? "warning: " : "info: ");
+			out << this->file->relative << ':' << this->line << ':' << this->col << ": ";
+
+			const std::string_view arguments[] = { std::string_view(this->text).substr(0, this->split), std::string_view(this->text).substr(this->split) };
+			std::size_t argument = 0;
+			for (const char* c = this->format; *c; c++) {
+				if (*c == '%' && argument < 2)
+					out << arguments[argument++];
+				else
+					out << *c;
+			}
+			out << '\n';
+
+			// the line pointed at, with tabs shown as single spaces, and carets under the characters
+			std::string line(this->file->source ? this->file->source->line(this->line) : std::string_view());
+			std::size_t col = this->col;
+			for (char& ch : line) {
+				if (ch == '\t') {
+					ch = ' ';
+					col -= 3;
+				}
+			}
+			out << line << '\n' << std::string(col - 1, ' ') << std::string(this->length, '^') << '\n';
+		}
+
 		void error_handler::flush_stream(message_type type) noexcept {
+			std::ostringstream& stream = this->stream();
 			if (type == message_type::warning && !this->m_warnings) {
-				m_message_stream.str("");
+				stream.str("");
 				return;
 			}
 
 			type = type == message_type::warning && this->m_werror ? message_type::error : type;
 
-			this->m_messages.push_back(_message_pair_type(m_message_stream.str(), type));
-			m_message_stream.str("");
+			this->m_add(message(stream.str(), type));
+			stream.str("");
 		}
 
 		void error_handler::print(const bool color, std::ostream& out_stream, std::ostream& err_stream) const {
-			for (const auto& [message, type] : this->m_messages) {
-				if (type == message_type::error) {
-					if (color && logging::has_colored_console()) {
-						err_stream << logging::lred << message << logging::creset;
-					} else {
-						err_stream << message;
-					}
-				} else if (type == message_type::warning) {
-					if (color && logging::has_colored_console()) {
-						out_stream << logging::lyellow << message << logging::creset;
-					} else {
-						out_stream << message;
-					}
-				} else if (type == message_type::info) {
-					if (color && logging::has_colored_console()) {
-						out_stream << logging::lblue << message << logging::creset;
-					} else {
-						out_stream << message;
-					}
-				} else {
-					out_stream << message;
-				}
-			}
+			for (const message& message : this->m_messages)
+				print_message(message, color, out_stream, err_stream);
 
 			err_stream.flush();
 			out_stream.flush();
 		}
 
 		void error_handler::print_exit(const bool color, std::ostream& out_stream, std::ostream& err_stream) const {
-			const bool __exit = std::find_if(this->m_messages.cbegin(), this->m_messages.cend(), [](const _message_pair_type& p) {
-				return p.second == message_type::error;
-				}) != this->m_messages.cend();
+			const bool __exit = this->m_error_count != 0;
 
 				print(color, out_stream, err_stream);
 
 				if (__exit) shift::utils::exit(EXIT_FAILURE);
 		}
 
-		size_t error_handler::get_error_count(void) const {
-			return std::count_if(this->m_messages.cbegin(), this->m_messages.cend(), [](const _message_pair_type& p) {
-				return p.second == message_type::error;
-				});
-		}
-
-		size_t error_handler::get_warning_count(void) const {
-			return std::count_if(this->m_messages.cbegin(), this->m_messages.cend(), [](const _message_pair_type& p) {
-				return p.second == message_type::warning;
-				});
-		}
-
 		void error_handler::rollback(void) noexcept {
 			if (this->m_marks.empty()) return;
 
-			const auto mark = this->m_marks.top();
-
-			this->m_messages.resize(std::min(mark, this->m_messages.size()));
+			const mark_type mark = this->m_marks.top();
+			if (mark.messages < this->m_messages.size()) {
+				this->m_messages.erase(this->m_messages.begin() + mark.messages, this->m_messages.end());
+				this->m_error_count = mark.errors;
+				this->m_warning_count = mark.warnings;
+			}
 
 			this->m_marks.pop();
 		}
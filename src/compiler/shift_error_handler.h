@@ -6,15 +6,22 @@
 
 #include "utils/utils.h"
 
-#include <list>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <utility>
+#include <vector>
 
  /** Namespace shift */
 namespace shift {
 	/** Namespace compiler */
 	namespace compiler {
+		class source_map;
+
 		class error_handler {
 		public:
 			enum message_type {
@@ -22,9 +29,41 @@ namespace shift {
 				warning, // Represents a warning message from the compiler.
 				info
 			};
-		private:
-			typedef std::pair<std::string, message_type> _message_pair_type;
-		public:
+
+			/// A source file diagnostics point into, shared by the diagnostics of the file
+			struct source_file {
+				std::filesystem::path path;
+				std::shared_ptr<const source_map> source;
+				mutable std::string relative; // path relative to the working directory, worked out when first printed
+			};
+
+			/**
+			 * A message of the handler.
+			 *
+			 * Messages are either added as text, or as diagnostics: a format, the arguments it refers to, and the place in
+			 * a source file they are about. A diagnostic is only formatted, with the source line it points at, when it is
+			 * printed or its text is asked for, so diagnostics that are never printed (such as those rolled back, see
+			 * rollback()) cost little more than their arguments.
+			 */
+			struct message {
+				message_type type = message_type::info;
+				message_type severity = message_type::info; // as reported, before -Werror made a warning an error
+				std::string text; // the text of the message, or the arguments of a diagnostic, one after the other
+				std::shared_ptr<const source_file> file; // null for messages added as text
+				const char* format = nullptr; // each '%' stands for the next argument
+				std::uint32_t line = 0, col = 0, length = 0; // the characters the diagnostic points at
+				std::uint32_t split = 0; // size of the first argument within text
+
+				message(void) = default;
+				inline message(std::string text, const message_type type) noexcept: type(type), severity(type), text(std::move(text)) {}
+
+				inline bool is_diagnostic(void) const noexcept { return this->file != nullptr; }
+
+				/// The text of the message, as it is printed
+				std::string get_text(void) const;
+				void write(std::ostream& out) const;
+			};
+
 			error_handler() = default;
 			inline error_handler(const error_handler&) noexcept;
 			error_handler(error_handler&&) noexcept = default;
@@ -40,8 +79,42 @@ namespace shift {
 			error_handler& add_warning(std::string&& msg) noexcept;
 			error_handler& add_error(std::string&& msg) noexcept;
 
-			// Convenient stream for writing warnings and errors
-			inline std::ostringstream& stream(void) noexcept { return m_message_stream; }
+			/**
+			 * Adds a diagnostic pointing at @a length characters from @a line:@a col of @a file, which is formatted only when it
+			 * is printed (see message). Like flush_stream(), warnings are dropped unless they are printed, and made errors with
+			 * -Werror.
+			 */
+			error_handler& add_diagnostic(message_type type, const std::shared_ptr<const source_file>& file, std::uint32_t line, std::uint32_t col,
+				std::uint32_t length, const char* format, std::string_view first = std::string_view(), std::string_view second = std::string_view());
+
+			/// Adds a message as it is, regardless of whether warnings are printed
+			error_handler& add_message(message msg);
+
+			/// Formats every diagnostic of the handler, which must be done before the source they point into changes
+			void format(void);
+
+			/**
+			 * A handler for diagnostics that are reported apart from this one, on another thread or for another file, and then
+			 * moved into it (see append()). It prints warnings, and makes them errors, as this one does, and stops at the error
+			 * limit once as many errors as this one still accepts have been reported to it.
+			 */
+			error_handler branch(void) const;
+
+			/**
+			 * Moves the messages of @a other to the end of this handler, which @a other is left without. Branches reported to
+			 * on different threads need no lock of their own; only appending them to this handler has to be done on one
+			 * thread at a time.
+			 */
+			inline void append(error_handler& other) { this->insert({ { this->m_messages.size(), &other } }); }
+
+			/**
+			 * Moves the messages of every handler of @a others in at the position paired with it, counted in the messages this
+			 * handler had before, as if they had been reported there. The positions must be in order, and past every mark.
+			 */
+			void insert(const std::vector<std::pair<size_t, error_handler*>>& others);
+
+			// Convenient stream for writing warnings and errors, created on first use so that branches are cheap to make
+			std::ostringstream& stream(void);
 			inline std::ostringstream& get_stream(void) noexcept { return stream(); }
 
 			// Flushes the std::ostringstream from stream(), considering all the text currently held within it to be a message of this type
@@ -57,16 +130,38 @@ namespace shift {
 			// Prints and clears the internal message list
 			inline void print_clear(const bool color = true, std::ostream& out_stream = std::cout, std::ostream& err_stream = std::cerr) {
 				print(color, out_stream, err_stream);
-				this->m_messages.clear();
+				this->clear();
 			}
 
 			inline void print_exit_clear(const bool color = true, std::ostream& out_stream = std::cout, std::ostream& err_stream = std::cerr) {
 				print_exit(color, out_stream, err_stream);
+				this->clear();
+			}
+
+			// Removes every message, though not the marks
+			inline void clear(void) noexcept {
 				this->m_messages.clear();
+				this->m_error_count = this->m_warning_count = 0;
 			}
 
-			size_t get_error_count(void) const;
-			size_t get_warning_count(void) const;
+			inline size_t get_error_count(void) const noexcept { return this->m_error_count; }
+			inline size_t get_warning_count(void) const noexcept { return this->m_warning_count; }
+
+			/**
+			 * Sets the number of errors after which the handler takes no more messages, 0 for no limit. Once the limit is
+			 * reached, the tokenizer and parser reporting to the handler stop early (see is_error_limit_reached()).
+			 */
+			inline void set_max_errors(const size_t max_errors) noexcept { this->m_max_errors = max_errors; }
+			inline size_t get_max_errors(void) const noexcept { return this->m_max_errors; }
+			inline bool is_error_limit_reached(void) const noexcept { return this->m_max_errors != 0 && this->m_errors_before + this->m_error_count >= this->m_max_errors; }
+
+			/**
+			 * Makes the handler print every message as it takes it, rather than holding on to it until print() (see
+			 * -diagnostics-stream). The messages it already holds are printed first. Messages printed this way are only
+			 * counted, and cannot be rolled back.
+			 */
+			void set_print_immediately(bool immediately = true);
+			inline bool is_print_immediately(void) const noexcept { return this->m_print_immediately; }
 
 			inline void set_werror(const bool werror = true) noexcept { this->m_werror = werror; }
 			inline bool is_werror(void) const noexcept { return this->m_werror; }
@@ -84,7 +179,7 @@ namespace shift {
 			 *
 			 * @see rollback()
 			 */
-			inline void mark(void) noexcept { this->m_marks.push(this->m_messages.size()); } // Mark current warnings and errors
+			inline void mark(void) noexcept { this->m_marks.push({ this->m_messages.size(), this->m_error_count, this->m_warning_count }); } // Mark current warnings and errors
 
 			/**
 			 * Rolls back to the most recent mark, popping it off the stack to remove it from further use.
@@ -93,20 +188,32 @@ namespace shift {
 
 			inline void pop_mark() { return pop_marks(1); }
 
-			inline void pop_marks(typename std::stack<typename std::list<_message_pair_type>::size_type>::size_type count = -1) noexcept { utils::pop_stack(this->m_marks, count); }
+			inline void pop_marks(size_t count = -1) noexcept { utils::pop_stack(this->m_marks, count); }
+
+			inline const std::vector<message>& get_messages(void) const noexcept { return this->m_messages; }
+		private:
+			// What a mark restores; the counts are kept along with it so that rolling back does not have to count again
+			struct mark_type {
+				size_t messages, errors, warnings;
+			};
 
-			inline const std::stack<typename std::list<_message_pair_type>::size_type>& get_marks(void) const noexcept { return this->m_marks; }
-			inline std::list<_message_pair_type>& get_messages(void) noexcept { return this->m_messages; }
-			inline const std::list<_message_pair_type>& get_messages(void) const noexcept { return this->m_messages; }
+			bool m_add(message&& msg);
 		private:
 			bool m_warnings = false, m_werror = false;
-			std::list<_message_pair_type> m_messages;
-			std::stack<typename std::list<_message_pair_type>::size_type> m_marks;
-			std::ostringstream m_message_stream;
+			bool m_print_immediately = false;
+			std::vector<message> m_messages;
+			std::stack<mark_type> m_marks;
+			std::unique_ptr<std::ostringstream> m_message_stream;
+			size_t m_error_count = 0, m_warning_count = 0;
+			size_t m_max_errors = 0;
+			size_t m_errors_before = 0; // errors already reported to the handler this one is a branch of, see branch()
 		};
 
 		inline error_handler::error_handler(const error_handler& other) noexcept: m_warnings(other.m_warnings), m_werror(other.m_werror),
-			m_messages(other.m_messages), m_marks(other.m_marks), m_message_stream(other.m_message_stream.str()) {}
+			m_print_immediately(other.m_print_immediately), m_messages(other.m_messages), m_marks(other.m_marks),
+			m_message_stream(other.m_message_stream ? std::make_unique<std::ostringstream>(other.m_message_stream->str()) : nullptr),
+			m_error_count(other.m_error_count), m_warning_count(other.m_warning_count), m_max_errors(other.m_max_errors),
+			m_errors_before(other.m_errors_before) {}
 	}
 }
 
@@ -0,0 +1,128 @@
+/**
+ * @file compiler/shift_flat_tree.cpp
+ */
+
+#include "compiler/shift_flat_tree.h"
+#include "compiler/shift_thread_pool.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <variant>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		namespace {
+			inline bool is_empty(const flat_tree::expression& expr) noexcept { return expr.type == token::token_type::NULL_TOKEN; }
+		}
+
+		void flat_tree::assign(const function& func, const order order) {
+			using statement_type = statement::statement_type;
+
+			this->m_nodes.clear();
+			this->m_function = &func;
+			this->m_order = order;
+
+			// The body is laid out in pre-order first, from a stack of the nodes yet to be laid out; the children of a node
+			// are pushed in reverse, so that they come off the stack in order.
+			std::vector<node> pending;
+			const auto push = [&pending](const auto& value) {
+				node n;
+				n.value = &value;
+				n.is_statement = std::is_same_v<std::decay_t<decltype(value)>, statement>;
+				pending.push_back(n);
+			};
+
+			for (const statement& s : func.statements)
+				push(s);
+			std::reverse(pending.begin(), pending.end());
+
+			while (!pending.empty()) {
+				node n = pending.back();
+				pending.pop_back();
+				const std::size_t first = pending.size();
+
+				if (const statement* const s = n.get_statement()) {
+					auto sub = s->sub.cbegin();
+					if (s->get_type() == statement_type::for_ && sub != s->sub.cend())
+						push(*sub++);
+
+					std::visit([&push](const auto& data) {
+						using data_type = std::decay_t<decltype(data)>;
+						if constexpr (std::is_same_v<data_type, statement::expression_data> || std::is_same_v<data_type, statement::keyword_data>) {
+							if (!is_empty(data.expr))
+								push(data.expr);
+						} else if constexpr (std::is_same_v<data_type, statement::variable_data>) {
+							if (!is_empty(data.variable.value))
+								push(data.variable.value);
+						} else if constexpr (std::is_same_v<data_type, statement::for_data>) {
+							if (!is_empty(data.condition))
+								push(data.condition);
+							if (!is_empty(data.increment))
+								push(data.increment);
+						}
+					}, s->data);
+
+					for (; sub != s->sub.cend(); ++sub)
+						push(*sub);
+				} else {
+					for (const expression& operand : n.get_expression()->sub)
+						push(operand);
+				}
+
+				n.children = static_cast<std::uint32_t>(pending.size() - first);
+				std::reverse(pending.begin() + first, pending.end());
+				this->m_nodes.push_back(n);
+			}
+
+			// sizes, from the last node back, as the children of a node follow it one subtree after the other
+			for (std::size_t index = this->m_nodes.size(); index-- > 0;) {
+				node& n = this->m_nodes[index];
+				std::size_t child = index + 1;
+				for (std::uint32_t count = 0; count < n.children; count++)
+					child += this->m_nodes[child].size;
+				n.size = static_cast<std::uint32_t>(child - index);
+			}
+
+			// depths, from the ends of the subtrees the node lies in
+			std::vector<std::size_t> ends;
+			for (std::size_t index = 0; index < this->m_nodes.size(); index++) {
+				while (!ends.empty() && ends.back() <= index)
+					ends.pop_back();
+				this->m_nodes[index].depth = static_cast<std::uint32_t>(ends.size());
+				ends.push_back(index + this->m_nodes[index].size);
+			}
+
+			if (order == order::post) {
+				// in post-order, a node comes after the nodes of its subtree and before its ancestors, which moves it from
+				// pre-order index i to i + size - 1 - depth
+				std::vector<node> post(this->m_nodes.size());
+				for (std::size_t index = 0; index < this->m_nodes.size(); index++) {
+					const node& n = this->m_nodes[index];
+					post[index + n.size - 1 - n.depth] = n;
+				}
+				this->m_nodes.swap(post);
+			}
+		}
+
+		std::vector<flat_tree> flat_tree::flatten(const parser& parsed, const order order, thread_pool* const pool) {
+			std::vector<const function*> functions;
+			for (const parser::shift_class& clazz : parsed.m_classes) {
+				for (const function& func : clazz.functions)
+					functions.push_back(&func);
+			}
+
+			std::vector<flat_tree> trees(functions.size());
+			const auto task = [&](const std::size_t index) { trees[index].assign(*functions[index], order); };
+
+			if (pool) {
+				pool->run(functions.size(), task);
+			} else {
+				for (std::size_t index = 0; index < functions.size(); index++)
+					task(index);
+			}
+			return trees;
+		}
+	}
+}
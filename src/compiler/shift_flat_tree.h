@@ -0,0 +1,129 @@
+/**
+ * @file compiler/shift_flat_tree.h
+ *
+ * Function bodies laid out as flat arrays of nodes, for the passes that walk the syntax tree
+ */
+#ifndef SHIFT_FLAT_TREE_H_
+#define SHIFT_FLAT_TREE_H_ 1
+
+#include "shift_config.h"
+#include "compiler/shift_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		class thread_pool;
+
+		/**
+		 * The statements and expressions of one function body, copied out of the syntax tree into a single array.
+		 *
+		 * Every node of the body takes one entry of the array, in pre-order (every node before its children) or in
+		 * post-order (every node after its children), and records how many children it has and how many nodes its
+		 * subtree holds. A pass then reads the body front to back, or back to front, without chasing the lists of the
+		 * tree: in pre-order, the subtree of the node at index i is [i, i + size), and in post-order it is
+		 * (i - size, i]. Skipping a subtree, or stepping from a child to its next sibling, is a single addition.
+		 *
+		 * The children of a statement are its expressions, followed by its nested statements, except for a for
+		 * statement, whose initializer comes before its condition and increment so that the children are in source
+		 * order. The children of an expression are its operands. Empty expressions, such as the value of a bare
+		 * return, are left out.
+		 *
+		 * The nodes point into the syntax tree, so a flat tree is only valid for as long as the parser it was built from
+		 * is, and until that parser parses or edits the file again. Flat trees are independent of each other and only
+		 * read the syntax tree, so the bodies of a file may be flattened and walked concurrently (see flatten()).
+		 */
+		class flat_tree {
+		public:
+			using statement = parser::shift_statement;
+			using expression = parser::shift_expression;
+			using function = parser::shift_function;
+
+			enum class order: uint_fast8_t {
+				pre,
+				post
+			};
+
+			struct node {
+				const void* value = nullptr; // the statement or expression
+				std::uint32_t children = 0; // number of direct children
+				std::uint32_t size = 1; // number of nodes in the subtree, this one included
+				std::uint32_t depth = 0; // 0 for the statements of the body itself
+				bool is_statement = false;
+
+				inline const statement* get_statement(void) const noexcept { return is_statement ? static_cast<const statement*>(value) : nullptr; }
+				inline const expression* get_expression(void) const noexcept { return is_statement ? nullptr : static_cast<const expression*>(value); }
+			};
+
+			using const_iterator = std::vector<node>::const_iterator;
+		public:
+			flat_tree(void) noexcept = default;
+
+			/// Lays out the body of @a func, which must have been parsed (see parser::parse_bodies())
+			inline explicit flat_tree(const function& func, const order order = order::pre) { this->assign(func, order); }
+
+			/// Lays out the body of @a func, which must have been parsed (see parser::parse_bodies()), replacing any previous one
+			void assign(const function& func, order order = order::pre);
+
+			/**
+			 * Lays out the body of every function of a parsed file, in the order of the classes and of their functions;
+			 * with a pool, the functions are spread over its threads. The bodies must have been parsed (see
+			 * parser::parse_bodies()).
+			 */
+			static std::vector<flat_tree> flatten(const parser& parsed, order order = order::pre, thread_pool* pool = nullptr);
+
+			inline const function* get_function(void) const noexcept { return this->m_function; }
+			inline order get_order(void) const noexcept { return this->m_order; }
+
+			inline const_iterator begin(void) const noexcept { return this->m_nodes.cbegin(); }
+			inline const_iterator end(void) const noexcept { return this->m_nodes.cend(); }
+			inline std::size_t size(void) const noexcept { return this->m_nodes.size(); }
+			inline bool empty(void) const noexcept { return this->m_nodes.empty(); }
+			inline const node& operator[](const std::size_t index) const noexcept { return this->m_nodes[index]; }
+
+			/// Index of the node following the subtree of the node at @a index in the array: its next sibling in pre-order
+			inline std::size_t next(const std::size_t index) const noexcept {
+				return this->m_order == order::pre ? index + this->m_nodes[index].size : index + 1;
+			}
+
+			/**
+			 * Walks a pre-order tree, calling visitor.enter(node) on every node before its children, and visitor.leave(node)
+			 * after them. Returning false from enter() skips the children of the node, and its leave().
+			 */
+			template<typename V>
+			void walk(V&& visitor) const;
+		private:
+			std::vector<node> m_nodes;
+			const function* m_function = nullptr;
+			order m_order = order::pre;
+		};
+
+		template<typename V>
+		void flat_tree::walk(V&& visitor) const {
+			// ends of the subtrees entered, with the nodes to leave once they are reached
+			std::vector<std::size_t> open;
+			for (std::size_t index = 0; index < this->m_nodes.size();) {
+				while (!open.empty() && index >= open.back() + this->m_nodes[open.back()].size) {
+					visitor.leave(this->m_nodes[open.back()]);
+					open.pop_back();
+				}
+
+				if (visitor.enter(this->m_nodes[index])) {
+					open.push_back(index);
+					index++;
+				} else {
+					index += this->m_nodes[index].size;
+				}
+			}
+
+			for (; !open.empty(); open.pop_back())
+				visitor.leave(this->m_nodes[open.back()]);
+		}
+	}
+}
+
+#endif /* SHIFT_FLAT_TREE_H_ */
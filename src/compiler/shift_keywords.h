@@ -0,0 +1,154 @@
+/**
+ * @file compiler/shift_keywords.h
+ *
+ * Compile-time perfect hash used to classify identifiers as keywords
+ */
+#ifndef SHIFT_KEYWORDS_H_
+#define SHIFT_KEYWORDS_H_ 1
+
+#include "shift_config.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/** Namespace keywords */
+		namespace keywords {
+			/// Keyword IDs; every identifier that is not one of these is classified as KW_NONE
+			enum keyword_type: std::uint8_t {
+				KW_NONE = 0,
+				KW_NULL, // null
+				KW_MODULE, // module
+				KW_NAMESPACE, // namespace
+				KW_CONST, // const
+				KW_PUBLIC, // public
+				KW_PROTECTED, // protected
+				KW_PRIVATE, // private
+				KW_STATIC, // static
+				KW_BINARY, // binary
+				KW_VOID, // void
+				KW_REQ, // req
+				KW_USE, // use
+				KW_UNSAFE, // unsafe
+				KW_EXTERN, // extern
+				KW_EXT, // ext
+				KW_CLASS, // class
+				KW_INIT, // init
+				KW_OPERATOR, // operator
+				KW_CONSTRUCTOR, // constructor
+				KW_DESTRUCTOR, // destructor
+				KW_IF, // if
+				KW_ELSE, // else
+				KW_WHILE, // while
+				KW_DO, // do
+				KW_RETURN, // return
+				KW_CONTINUE, // continue
+				KW_BREAK, // break
+				KW_FOR, // for
+				KW_THIS, // this
+				KW_BASE, // base
+				KW_NEW, // new
+				KW_THROW, // throw
+				KW_ALIAS, // alias
+				KW_TRUE, // true
+				KW_FALSE, // false
+				KW_ASM, // asm
+				KW_ASM_UNDERSCORE, // _asm_
+				KW_ASM_DOUBLE_UNDERSCORE, // __asm__
+
+				KW_COUNT
+			};
+
+			static_assert(KW_COUNT <= 64, "keyword masks are 64 bits wide");
+
+			/// Set of keywords, one bit per keyword_type
+			using keyword_mask = std::uint64_t;
+
+			template<keyword_type... Keywords>
+			inline constexpr keyword_mask mask_of = ((keyword_mask(1) << Keywords) | ... | keyword_mask(0));
+
+			constexpr inline bool is_any(const keyword_type keyword, const keyword_mask mask) noexcept { return ((keyword_mask(1) << keyword) & mask) != 0; }
+
+			inline constexpr keyword_mask EXTERN = mask_of<KW_EXTERN, KW_EXT>;
+			inline constexpr keyword_mask ASM = mask_of<KW_ASM, KW_ASM_UNDERSCORE, KW_ASM_DOUBLE_UNDERSCORE>;
+			inline constexpr keyword_mask ACCESS_SPECIFIERS = mask_of<KW_PUBLIC, KW_PROTECTED, KW_PRIVATE, KW_STATIC, KW_BINARY, KW_CONST,
+				KW_UNSAFE> | EXTERN;
+
+			/// Keywords that can not be used as names (note: null, new, throw, alias and asm are not part of this set)
+			inline constexpr keyword_mask RESERVED = mask_of<KW_BINARY, KW_CONST, KW_MODULE, KW_NAMESPACE, KW_PRIVATE, KW_PROTECTED, KW_PUBLIC,
+				KW_REQ, KW_UNSAFE, KW_USE, KW_VOID, KW_CLASS, KW_INIT, KW_OPERATOR, KW_CONSTRUCTOR, KW_DESTRUCTOR, KW_THIS, KW_BASE, KW_IF,
+				KW_ELSE, KW_WHILE, KW_DO, KW_RETURN, KW_CONTINUE, KW_BREAK, KW_FOR, KW_TRUE, KW_FALSE> | EXTERN | ACCESS_SPECIFIERS;
+
+			struct keyword_entry {
+				std::string_view name;
+				keyword_type type = KW_NONE;
+			};
+
+			inline constexpr keyword_entry list[] = {
+				{ "null", KW_NULL }, { "module", KW_MODULE }, { "namespace", KW_NAMESPACE }, { "const", KW_CONST }, { "public", KW_PUBLIC },
+				{ "protected", KW_PROTECTED }, { "private", KW_PRIVATE }, { "static", KW_STATIC }, { "binary", KW_BINARY }, { "void", KW_VOID },
+				{ "req", KW_REQ }, { "use", KW_USE }, { "unsafe", KW_UNSAFE }, { "extern", KW_EXTERN }, { "ext", KW_EXT }, { "class", KW_CLASS },
+				{ "init", KW_INIT }, { "operator", KW_OPERATOR }, { "constructor", KW_CONSTRUCTOR }, { "destructor", KW_DESTRUCTOR },
+				{ "if", KW_IF }, { "else", KW_ELSE }, { "while", KW_WHILE }, { "do", KW_DO }, { "return", KW_RETURN }, { "continue", KW_CONTINUE },
+				{ "break", KW_BREAK }, { "for", KW_FOR }, { "this", KW_THIS }, { "base", KW_BASE }, { "new", KW_NEW }, { "throw", KW_THROW },
+				{ "alias", KW_ALIAS }, { "true", KW_TRUE }, { "false", KW_FALSE }, { "asm", KW_ASM }, { "_asm_", KW_ASM_UNDERSCORE },
+				{ "__asm__", KW_ASM_DOUBLE_UNDERSCORE },
+			};
+
+			static_assert(sizeof(list) / sizeof(*list) == KW_COUNT - 1, "every keyword must be listed exactly once");
+
+			inline constexpr std::size_t min_length = 2;
+			inline constexpr std::size_t max_length = 11;
+			inline constexpr std::size_t table_size = 128;
+
+			/**
+			 * Hashes the first, second and last characters and the length of a name.
+			 * The multipliers were chosen so that no two keywords share a slot (see the static_assert below).
+			 * @param[in] name A name of at least min_length characters.
+			 */
+			constexpr inline std::size_t hash(const std::string_view name) noexcept {
+				return (std::size_t(static_cast<unsigned char>(name[0])) + std::size_t(static_cast<unsigned char>(name[1])) * 6
+					+ std::size_t(static_cast<unsigned char>(name[name.length() - 1])) * 44 + name.length()) & (table_size - 1);
+			}
+
+			constexpr inline std::array<keyword_entry, table_size> make_table(void) noexcept {
+				std::array<keyword_entry, table_size> table {};
+				for (const keyword_entry& entry : list)
+					table[hash(entry.name)] = entry;
+				return table;
+			}
+
+			inline constexpr std::array<keyword_entry, table_size> table = make_table();
+
+			constexpr inline bool is_perfect(void) noexcept {
+				for (const keyword_entry& entry : list) {
+					if (entry.name.length() < min_length || entry.name.length() > max_length || table[hash(entry.name)].type != entry.type)
+						return false;
+				}
+				return true;
+			}
+
+			static_assert(is_perfect(), "keyword hash has collisions; adjust the multipliers in keywords::hash()");
+
+			/**
+			 * Classifies an identifier, with one hash and at most one string comparison.
+			 * @param[in] name The identifier.
+			 * @return The keyword ID of @a name, or KW_NONE if it is not a keyword.
+			 */
+			constexpr inline keyword_type classify(const std::string_view name) noexcept {
+				if (name.length() < min_length || name.length() > max_length)
+					return KW_NONE;
+
+				const keyword_entry& entry = table[hash(name)];
+				return entry.name == name ? entry.type : KW_NONE;
+			}
+		}
+	}
+}
+
+#endif /* SHIFT_KEYWORDS_H_ */
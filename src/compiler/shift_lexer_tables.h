@@ -0,0 +1,192 @@
+/**
+ * @file compiler/shift_lexer_tables.h
+ *
+ * Compile-time tables driving the tokenizer: what to do on the first character of a token, and the state machine that
+ * matches operators and punctuation
+ */
+#ifndef SHIFT_LEXER_TABLES_H_
+#define SHIFT_LEXER_TABLES_H_ 1
+
+#include "shift_config.h"
+#include "compiler/shift_scanner.h"
+#include "compiler/shift_tokenizer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/** Namespace lexer */
+		namespace lexer {
+			/// What the tokenizer does when a token starts with a given character
+			enum action: std::uint8_t {
+				INVALID = 0, // not part of the language
+				BLANK, // whitespace other than \n
+				NEWLINE, // \n
+				IDENTIFIER, // identifiers and keywords
+				NUMBER, // number literals
+				DOT, // a number literal if a digit follows, an operator otherwise
+				SLASH, // a comment if / or * follows, an operator otherwise
+				OPERATOR, // operators and punctuation, see match_operator()
+				STRING, // string literals
+				CHAR // character literals
+			};
+
+			struct operator_entry {
+				std::string_view spelling;
+				token::token_type type = token::token_type::NULL_TOKEN;
+				std::uint8_t length = 0; // number of characters taken when the whole spelling matches; 0 takes all of them
+			};
+
+			/**
+			 * Every operator, matched longest first.
+			 *
+			 * The =x spellings are accepted as x= (but =- and =! are not, since "i =- 3" means "i = -3"), and =+ is not
+			 * accepted when yet another + follows, so that "i =++j" means "i = ++j".
+			 */
+			inline constexpr operator_entry operators[] = {
+				{ ";", token::token_type::SEMICOLON }, { ",", token::token_type::COMMA }, { ":", token::token_type::COLON },
+				{ "?", token::token_type::QUESTION_MARK }, { "~", token::token_type::FLIP_BITS }, { "\\", token::token_type::BACKSLASH },
+				{ ".", token::token_type::DOT },
+				{ "{", token::token_type::LEFT_SCOPE_BRACKET }, { "}", token::token_type::RIGHT_SCOPE_BRACKET },
+				{ "(", token::token_type::LEFT_BRACKET }, { ")", token::token_type::RIGHT_BRACKET },
+				{ "[", token::token_type::LEFT_SQUARE_BRACKET }, { "]", token::token_type::RIGHT_SQUARE_BRACKET },
+
+				{ "!", token::token_type::NOT }, { "!=", token::token_type::NOT_EQUAL },
+				{ "&", token::token_type::AND }, { "&&", token::token_type::AND_AND }, { "&=", token::token_type::AND_EQUALS },
+				{ "|", token::token_type::OR }, { "||", token::token_type::OR_OR }, { "|=", token::token_type::OR_EQUALS },
+				{ "^", token::token_type::XOR }, { "^=", token::token_type::XOR_EQUALS },
+				{ "-", token::token_type::MINUS }, { "--", token::token_type::MINUS_MINUS }, { "-=", token::token_type::MINUS_EQUALS },
+				{ "+", token::token_type::PLUS }, { "++", token::token_type::PLUS_PLUS }, { "+=", token::token_type::PLUS_EQUALS },
+				{ "*", token::token_type::MULTIPLY }, { "*=", token::token_type::MULTIPLY_EQUALS },
+				{ "/", token::token_type::DIVIDE }, { "/=", token::token_type::DIVIDE_EQUALS },
+				{ "%", token::token_type::MODULO }, { "%=", token::token_type::MODULO_EQUALS },
+				{ ">", token::token_type::GREATER_THAN }, { ">=", token::token_type::GREATER_THAN_OR_EQUAL },
+				{ ">>", token::token_type::SHIFT_RIGHT }, { ">>=", token::token_type::SHIFT_RIGHT_EQUALS },
+				{ "<", token::token_type::LESS_THAN }, { "<=", token::token_type::LESS_THAN_OR_EQUAL },
+				{ "<<", token::token_type::SHIFT_LEFT }, { "<<=", token::token_type::SHIFT_LEFT_EQUALS },
+
+				{ "=", token::token_type::EQUALS }, { "==", token::token_type::EQUALS_EQUALS },
+				{ "=%", token::token_type::MODULO_EQUALS }, { "=*", token::token_type::MULTIPLY_EQUALS },
+				{ "=&", token::token_type::AND_EQUALS }, { "=|", token::token_type::OR_EQUALS }, { "=^", token::token_type::XOR_EQUALS },
+				{ "=/", token::token_type::DIVIDE_EQUALS }, { "=+", token::token_type::PLUS_EQUALS }, { "=++", token::token_type::EQUALS, 1 },
+				{ "=<", token::token_type::LESS_THAN_OR_EQUAL }, { "=<<", token::token_type::SHIFT_LEFT_EQUALS },
+				{ "=>", token::token_type::GREATER_THAN_OR_EQUAL }, { "=>>", token::token_type::SHIFT_RIGHT_EQUALS },
+			};
+
+			constexpr inline std::array<action, 256> make_actions(void) noexcept {
+				std::array<action, 256> actions {};
+
+				for (const operator_entry& entry : operators)
+					actions[static_cast<unsigned char>(entry.spelling[0])] = OPERATOR;
+
+				for (unsigned ch = 0; ch < 256; ch++) {
+					if (scanner::is_blank(char(ch))) actions[ch] = BLANK;
+					if (scanner::is_identifier_start(char(ch))) actions[ch] = IDENTIFIER;
+					if (scanner::is_digit(char(ch))) actions[ch] = NUMBER;
+				}
+
+				actions['\n'] = NEWLINE;
+				actions['.'] = DOT;
+				actions['/'] = SLASH;
+				actions['"'] = STRING;
+				actions['\''] = CHAR;
+				return actions;
+			}
+
+			inline constexpr std::array<action, 256> actions = make_actions();
+
+			/// Characters that appear in operators are numbered from 1; every other character (including the zero padding after the source) is 0
+			constexpr inline std::array<std::uint8_t, 256> make_alphabet(void) noexcept {
+				std::array<std::uint8_t, 256> alphabet {};
+				std::uint8_t symbols = 0;
+
+				for (const operator_entry& entry : operators) {
+					for (const char ch : entry.spelling) {
+						if (!alphabet[static_cast<unsigned char>(ch)])
+							alphabet[static_cast<unsigned char>(ch)] = ++symbols;
+					}
+				}
+				return alphabet;
+			}
+
+			inline constexpr std::array<std::uint8_t, 256> alphabet = make_alphabet();
+
+			constexpr inline std::size_t alphabet_size(void) noexcept {
+				std::size_t size = 0;
+				for (const std::uint8_t symbol : alphabet)
+					size = symbol > size ? symbol : size;
+				return size + 1;
+			}
+
+			/// Upper bound on the number of states of the operator state machine
+			inline constexpr std::size_t max_operator_states = 64;
+
+			struct operator_match {
+				token::token_type type = token::token_type::NULL_TOKEN;
+				std::size_t length = 0; // 0 if nothing matched
+			};
+
+			/// Trie of the operators: state 0 is the start state, and every other state is reached by exactly one prefix
+			struct operator_machine {
+				std::array<std::array<std::uint8_t, alphabet_size()>, max_operator_states> next {}; // 0 where the prefix leads nowhere
+				std::array<operator_match, max_operator_states> accept {}; // what the prefix of each state matches, if anything
+				std::size_t size = 1;
+			};
+
+			constexpr inline operator_machine make_operator_machine(void) noexcept {
+				operator_machine machine {};
+
+				for (const operator_entry& entry : operators) {
+					std::size_t state = 0;
+					for (const char ch : entry.spelling) {
+						std::uint8_t& next = machine.next[state][alphabet[static_cast<unsigned char>(ch)]];
+						if (!next)
+							next = static_cast<std::uint8_t>(machine.size++);
+						state = next;
+					}
+					machine.accept[state] = { entry.type, entry.length ? entry.length : entry.spelling.length() };
+				}
+				return machine;
+			}
+
+			inline constexpr operator_machine operator_states = make_operator_machine();
+
+			static_assert(operator_states.size <= max_operator_states, "too many operator states; raise max_operator_states");
+
+			/**
+			 * Matches the longest operator at the start of some text.
+			 * @param[in] ptr The text, which must be followed by a character that is not part of any operator (such as the
+			 * zero padding after the source).
+			 * @return The matched operator, with a length of 0 if there is none.
+			 */
+			constexpr inline operator_match match_operator(const char* const ptr) noexcept {
+				operator_match match;
+				for (std::size_t state = 0, index = 0;; index++) {
+					state = operator_states.next[state][alphabet[static_cast<unsigned char>(ptr[index])]];
+					if (!state)
+						return match;
+					if (operator_states.accept[state].length)
+						match = operator_states.accept[state];
+				}
+			}
+
+			constexpr inline bool is_unambiguous(void) noexcept {
+				for (const operator_entry& entry : operators) {
+					const operator_match match = match_operator(entry.spelling.data());
+					if (match.type != entry.type || match.length != (entry.length ? entry.length : entry.spelling.length()))
+						return false;
+				}
+				return true;
+			}
+
+			static_assert(is_unambiguous(), "every operator must be listed exactly once");
+		}
+	}
+}
+
+#endif /* SHIFT_LEXER_TABLES_H_ */
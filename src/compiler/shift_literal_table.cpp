@@ -0,0 +1,179 @@
+/**
+ * @file compiler/shift_literal_table.cpp
+ */
+
+#include "compiler/shift_literal_table.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		namespace {
+			/// Character an escape sequence stands for, given the character after the backslash
+			char unescape(const char ch) noexcept {
+				// the tokenizer accepts these case insensitively, and has already reported any unknown sequence
+				switch (std::tolower(static_cast<unsigned char>(ch))) {
+					case 'a': return '\a';
+					case 'b': return '\b';
+					case 'f': return '\f';
+					case 'n': return '\n';
+					case 'r': return '\r';
+					case 't': return '\t';
+					case 'v': return '\v';
+					default: return ch; // \\, \', \" and unknown sequences stand for the character itself
+				}
+			}
+
+			template<typename T, typename... Args>
+			bool parse_number(const std::string_view text, T& value, Args... args) noexcept {
+				const char* const end = text.data() + text.size();
+				const std::from_chars_result result = std::from_chars(text.data(), end, value, args...);
+				return result.ec == std::errc() && result.ptr == end;
+			}
+		}
+
+		const literal& literal_table::add(const std::uint32_t offset, const literal::literal_kind kind, std::string_view text) {
+			literal value;
+			value.kind = kind;
+
+			switch (kind) {
+				case literal::INTEGER: {
+					int base = 10;
+					if (text.size() >= 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+						base = 16;
+						text.remove_prefix(2);
+					} else if (text.size() >= 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+						base = 2;
+						text.remove_prefix(2);
+					}
+
+					value.valid = parse_number(text, value.integer, base);
+					break;
+				}
+				case literal::FLOAT:
+				case literal::DOUBLE: {
+					if (!text.empty() && (text.back() == 'f' || text.back() == 'F' || text.back() == 'd' || text.back() == 'D'))
+						text.remove_suffix(1);
+
+					if (kind == literal::FLOAT) {
+						value.single = 0;
+						value.valid = parse_number(text, value.single);
+					} else {
+						value.real = 0;
+						value.valid = parse_number(text, value.real);
+					}
+					break;
+				}
+				case literal::STRING: {
+					// stop where the tokenizer stopped: at the closing quote, or at the end of the line of an unterminated string
+					const std::size_t end = std::min(text.find_first_of("\"\\\n", 1), text.size());
+					value.valid = false;
+
+					if (end < text.size() && text[end] == '"') { // no escape sequences, intern the source directly
+						value.valid = true;
+						value.string = this->intern(text.substr(1, end - 1));
+						break;
+					}
+
+					this->m_scratch.assign(text.data() + 1, end - 1);
+					for (std::size_t i = end; i < text.size(); i++) {
+						const char ch = text[i];
+						if (ch == '"') {
+							value.valid = true;
+							break;
+						}
+
+						if (ch == '\n')
+							break;
+
+						if (ch == '\\') {
+							if (i + 1 >= text.size() || text[i + 1] == '\n')
+								break;
+							this->m_scratch.push_back(unescape(text[++i]));
+							continue;
+						}
+
+						this->m_scratch.push_back(ch);
+					}
+
+					value.string = this->intern(this->m_scratch);
+					break;
+				}
+				case literal::CHAR: {
+					if (text.size() >= 4 && text[1] == '\\') {
+						value.character = unescape(text[2]);
+						value.valid = text.size() == 4 && text[3] == '\'';
+					} else {
+						value.character = text.size() >= 2 ? text[1] : char(0);
+						value.valid = text.size() == 3 && text[2] == '\'';
+					}
+					break;
+				}
+				default:
+					value.valid = false;
+					break;
+			}
+
+			if (this->m_offsets.empty() || this->m_offsets.back() < offset) {
+				this->m_offsets.push_back(offset);
+				this->m_values.push_back(value);
+				return this->m_values.back();
+			}
+
+			// only re-lexed parts of an edited source are added out of order
+			const std::size_t index = std::size_t(std::lower_bound(this->m_offsets.cbegin(), this->m_offsets.cend(), offset) - this->m_offsets.cbegin());
+			this->m_offsets.insert(this->m_offsets.begin() + index, offset);
+			return *this->m_values.insert(this->m_values.begin() + index, value);
+		}
+
+		const literal* literal_table::find(const std::size_t offset) const noexcept {
+			const auto it = std::lower_bound(this->m_offsets.cbegin(), this->m_offsets.cend(), offset, [](const std::uint32_t a, const std::size_t b) {
+				return a < b;
+				});
+			return it != this->m_offsets.cend() && *it == offset ? &this->m_values[std::size_t(it - this->m_offsets.cbegin())] : nullptr;
+		}
+
+		void literal_table::insert(const std::uint32_t offset, const literal& value) {
+			this->m_offsets.push_back(offset);
+			this->m_values.push_back(value);
+		}
+
+		void literal_table::edit(const std::uint32_t begin, const std::uint32_t end, const std::int64_t delta) noexcept {
+			const std::size_t first = std::size_t(std::lower_bound(this->m_offsets.cbegin(), this->m_offsets.cend(), begin) - this->m_offsets.cbegin());
+			const std::size_t last = std::size_t(std::lower_bound(this->m_offsets.cbegin() + first, this->m_offsets.cend(), end) - this->m_offsets.cbegin());
+
+			this->m_offsets.erase(this->m_offsets.begin() + first, this->m_offsets.begin() + last);
+			this->m_values.erase(this->m_values.begin() + first, this->m_values.begin() + last);
+
+			for (std::size_t i = first; i < this->m_offsets.size(); i++)
+				this->m_offsets[i] = static_cast<std::uint32_t>(this->m_offsets[i] + delta);
+		}
+
+		void literal_table::reserve(const std::size_t count) {
+			this->m_offsets.reserve(count);
+			this->m_values.reserve(count);
+		}
+
+		void literal_table::clear(void) noexcept {
+			this->m_offsets.clear();
+			this->m_values.clear();
+			this->m_string_index.clear();
+			this->m_strings.clear();
+		}
+
+		std::uint32_t literal_table::intern(const std::string_view str) {
+			const auto it = this->m_string_index.find(str);
+			if (it != this->m_string_index.cend())
+				return it->second;
+
+			const std::uint32_t index = static_cast<std::uint32_t>(this->m_strings.size());
+			this->m_strings.emplace_back(str);
+			this->m_string_index.emplace(this->m_strings.back(), index);
+			return index;
+		}
+	}
+}
@@ -0,0 +1,119 @@
+/**
+ * @file compiler/shift_literal_table.h
+ *
+ * Values of the literals of a source file, decoded once while tokenizing
+ */
+#ifndef SHIFT_LITERAL_TABLE_H_
+#define SHIFT_LITERAL_TABLE_H_ 1
+
+#include "shift_config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/// Decoded value of a literal token
+		struct literal {
+			enum literal_kind: std::uint8_t {
+				NONE = 0,
+				INTEGER, // decimal, hexadecimal and binary numbers
+				FLOAT,
+				DOUBLE,
+				STRING,
+				CHAR
+			};
+
+			literal_kind kind = NONE;
+			bool valid = true; // false if the literal is malformed (e.g. 0x or an unterminated string) or out of range
+
+			union {
+				std::uint64_t integer = 0;
+				float single;
+				double real;
+				std::uint32_t string; // index into the string pool of the table, see literal_table::string()
+				char character;
+			};
+		};
+
+		/**
+		 * Literal values of a source file, keyed by the offset of their token.
+		 *
+		 * Numbers are converted with std::from_chars, and strings have their escape sequences resolved and are interned, so
+		 * that equal strings share one pool entry (and index) no matter how they were spelled.
+		 */
+		class literal_table {
+		public:
+			literal_table(void) = default;
+			literal_table(const literal_table&) = delete;
+			literal_table(literal_table&&) = default;
+			~literal_table() noexcept = default;
+
+			literal_table& operator=(const literal_table&) = delete;
+			literal_table& operator=(literal_table&&) = default;
+
+			/**
+			 * Decodes a literal and records it.
+			 * @param[in] offset The byte offset of the token of the literal; there must not be a literal at that offset yet.
+			 * @param[in] kind The kind of literal.
+			 * @param[in] text The literal as written in the source, including any prefix, suffix and quotes.
+			 * @return The decoded literal.
+			 */
+			const literal& add(std::uint32_t offset, literal::literal_kind kind, std::string_view text);
+
+			/**
+			 * Records a literal that has already been decoded, e.g. one read back from a token cache.
+			 * @param[in] offset The byte offset of the token of the literal; offsets must be added in ascending order.
+			 * @param[in] value The literal; a string literal must index a string added with intern().
+			 */
+			void insert(std::uint32_t offset, const literal& value);
+
+			/**
+			 * Adds a string to the string pool, unless an equal string is already pooled.
+			 * @return The index of the string in the pool.
+			 */
+			std::uint32_t intern(std::string_view str);
+
+			/**
+			 * Finds the literal of a token.
+			 * @param[in] offset The byte offset of the token.
+			 * @return The literal, or nullptr if no literal token starts at @a offset.
+			 */
+			const literal* find(std::size_t offset) const noexcept;
+
+			/// Interned string at @a index in the string pool
+			inline std::string_view string(const std::uint32_t index) const noexcept { return index < this->m_strings.size() ? std::string_view(this->m_strings[index]) : std::string_view(); }
+
+			/// Offset of the token of the @a index th literal, in the order they were added
+			inline std::uint32_t offset(const std::size_t index) const noexcept { return this->m_offsets[index]; }
+			inline const literal& operator[](const std::size_t index) const noexcept { return this->m_values[index]; }
+
+			inline std::size_t size(void) const noexcept { return this->m_values.size(); }
+			inline std::size_t string_count(void) const noexcept { return this->m_strings.size(); }
+
+			/**
+			 * Follows an edit of the source: drops the literals at offsets within [@a begin, @a end), and moves those at or
+			 * past @a end by @a delta bytes. Strings that are no longer used stay in the pool.
+			 */
+			void edit(std::uint32_t begin, std::uint32_t end, std::int64_t delta) noexcept;
+
+			void reserve(std::size_t count);
+			void clear(void) noexcept;
+		private:
+			std::vector<std::uint32_t> m_offsets; // byte offset of the token of every literal, ascending
+			std::vector<literal> m_values;
+			std::deque<std::string> m_strings; // never reallocates its elements, so the views in m_string_index stay valid
+			std::unordered_map<std::string_view, std::uint32_t> m_string_index;
+			std::string m_scratch; // decoding buffer for strings with escape sequences
+		};
+	}
+}
+
+#endif /* SHIFT_LITERAL_TABLE_H_ */
@@ -0,0 +1,341 @@
+/**
+ * @file compiler/shift_module_file.cpp
+ */
+
+#include "compiler/shift_module_file.h"
+#include "compiler/shift_parser.h"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		namespace {
+			/**
+			 * Layout of a module file, all in native byte order:
+			 *
+			 *   header
+			 *   string_count    x { u32 offset, u32 length }  names, as ranges of the pool; name 0 is the empty name
+			 *   use_count       x { u32 name }
+			 *   class_count     x class_record
+			 *   function_count  x function_record
+			 *   parameter_count x parameter_record
+			 *   variable_count  x variable_record
+			 *   pool            the characters of every name
+			 *
+			 * Records refer to names and to records of other tables by index, and the header gives the offset of every
+			 * table from the start of the file.
+			 */
+			enum section_index: std::size_t {
+				STRINGS = 0,
+				POOL,
+				USES,
+				CLASSES,
+				FUNCTIONS,
+				PARAMETERS,
+				VARIABLES,
+				SECTION_COUNT
+			};
+
+			struct section {
+				std::uint32_t offset = 0, count = 0;
+			};
+
+			struct file_header {
+				char magic[8] = { 'S', 'H', 'I', 'F', 'T', 'M', 'O', 'D' };
+				std::uint32_t version = 1; // bump whenever the layout changes
+				std::uint32_t byte_order = 0x01020304;
+				std::uint32_t module = 0; // name of the module
+				std::uint32_t global_uses = 0; // number of global use statements, which come first in the use table
+				section sections[SECTION_COUNT];
+			};
+
+			struct string_record {
+				std::uint32_t offset = 0, length = 0;
+			};
+
+			struct type_record {
+				std::uint32_t name = 0, mods = 0;
+			};
+
+			struct class_record {
+				std::uint32_t name = 0, mods = 0, global_uses = 0;
+				module_file::range uses, functions, variables;
+			};
+
+			struct function_record {
+				std::uint32_t name = 0, mods = 0;
+				type_record return_type;
+				module_file::range parameters;
+			};
+
+			struct parameter_record {
+				type_record type;
+				std::uint32_t name = 0;
+			};
+
+			struct variable_record {
+				std::uint32_t name = 0;
+				type_record type;
+			};
+
+			constexpr file_header expected_header;
+
+			constexpr std::size_t record_size[SECTION_COUNT] = { sizeof(string_record), 1, sizeof(std::uint32_t), sizeof(class_record),
+				sizeof(function_record), sizeof(parameter_record), sizeof(variable_record) };
+
+			// records are written as they are in memory, so they must not hold any padding
+			static_assert(sizeof(file_header) == 8 + 4 * 4 + sizeof(section) * SECTION_COUNT);
+			static_assert(sizeof(class_record) == 9 * 4 && sizeof(function_record) == 6 * 4);
+			static_assert(sizeof(parameter_record) == 3 * 4 && sizeof(variable_record) == 3 * 4);
+
+			template<typename T>
+			inline T read(const char* const ptr) noexcept {
+				static_assert(std::is_trivially_copyable_v<T>);
+				T value;
+				std::memcpy(&value, ptr, sizeof(T));
+				return value;
+			}
+
+			template<typename T>
+			inline void write(std::string& out, const std::vector<T>& records) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+			}
+		}
+
+		bool module_file::open(const filesystem::file& file) noexcept {
+			if (!this->m_file.open(file))
+				return false;
+
+			const file_header header = this->m_file.size() >= sizeof(file_header) ? read<file_header>(this->m_file.data()) : file_header();
+			bool valid = this->m_file.size() >= sizeof(file_header) && std::memcmp(header.magic, expected_header.magic, sizeof(header.magic)) == 0
+				&& header.version == expected_header.version && header.byte_order == expected_header.byte_order;
+
+			// the only check made up front: every table lies within the file
+			for (std::size_t index = 0; valid && index < SECTION_COUNT; index++)
+				valid = std::uint64_t(header.sections[index].offset) + std::uint64_t(header.sections[index].count) * record_size[index] <= this->m_file.size();
+
+			if (!valid)
+				this->m_file.close();
+			return valid;
+		}
+
+		std::string module_file::serialize(const parser& parsed) {
+			std::vector<string_record> strings(1);
+			std::string pool;
+			std::unordered_map<std::string, std::uint32_t> names { { std::string(), 0 } };
+
+			const auto intern = [&](std::string&& name) {
+				const auto [it, inserted] = names.emplace(std::move(name), static_cast<std::uint32_t>(strings.size()));
+				if (inserted) {
+					strings.push_back({ static_cast<std::uint32_t>(pool.size()), static_cast<std::uint32_t>(it->first.size()) });
+					pool += it->first;
+				}
+				return it->second;
+			};
+
+			const auto intern_token = [&](const token* const token) { return token ? intern(std::string(token->get_data())) : 0u; };
+
+			const auto intern_name = [&](const parser::shift_name& name) {
+				std::string text;
+				if (name.size() > 0) {
+					for (auto it = name.begin; it != name.end; ++it)
+						text += it->get_data();
+				}
+				return intern(std::move(text));
+			};
+
+			const auto intern_type = [&](const parser::shift_type& type) { return type_record { intern_name(type.name), static_cast<std::uint32_t>(type.mods) }; };
+
+			file_header header;
+			header.module = intern_name(parsed.m_module);
+
+			std::vector<std::uint32_t> uses;
+			for (const parser::shift_module& use : parsed.m_global_uses)
+				uses.push_back(intern_name(use));
+			header.global_uses = static_cast<std::uint32_t>(uses.size());
+
+			std::vector<class_record> classes;
+			std::vector<function_record> functions;
+			std::vector<parameter_record> parameters;
+			std::vector<variable_record> variables;
+
+			for (const parser::shift_class& clazz : parsed.m_classes) {
+				class_record record;
+				record.name = intern_token(clazz.name);
+				record.mods = static_cast<std::uint32_t>(clazz.mods);
+
+				if (clazz.implicit_use_statements) {
+					for (const parser::shift_module& use : parsed.m_global_uses) {
+						record.global_uses++;
+						if (&use == clazz.implicit_use_statements)
+							break;
+					}
+				}
+
+				record.uses = { static_cast<std::uint32_t>(uses.size()), clazz.use_statements.size() };
+				for (const parser::shift_module& use : clazz.use_statements)
+					uses.push_back(intern_name(use));
+
+				record.functions = { static_cast<std::uint32_t>(functions.size()), clazz.functions.size() };
+				for (const parser::shift_function& func : clazz.functions) {
+					functions.push_back({ intern_token(func.name), static_cast<std::uint32_t>(func.mods), intern_type(func.return_type),
+						{ static_cast<std::uint32_t>(parameters.size()), func.parameters.size() } });
+
+					for (const auto& [param_type, param_name] : func.parameters)
+						parameters.push_back({ intern_type(param_type), intern_token(param_name) });
+				}
+
+				record.variables = { static_cast<std::uint32_t>(variables.size()), clazz.variables.size() };
+				for (const parser::shift_variable& variable : clazz.variables)
+					variables.push_back({ intern_token(variable.name), intern_type(variable.type) });
+
+				classes.push_back(record);
+			}
+
+			const std::size_t counts[SECTION_COUNT] = { strings.size(), pool.size(), uses.size(), classes.size(), functions.size(), parameters.size(), variables.size() };
+			constexpr section_index order[SECTION_COUNT] = { STRINGS, USES, CLASSES, FUNCTIONS, PARAMETERS, VARIABLES, POOL };
+
+			std::size_t offset = sizeof(header);
+			for (const section_index index : order) {
+				header.sections[index] = { static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(counts[index]) };
+				offset += counts[index] * record_size[index];
+			}
+
+			std::string out;
+			out.reserve(offset);
+			out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+			write(out, strings);
+			write(out, uses);
+			write(out, classes);
+			write(out, functions);
+			write(out, parameters);
+			write(out, variables);
+			out += pool;
+			return out;
+		}
+
+		bool module_file::store(const parser& parsed, const std::filesystem::path& path) {
+			const std::string data = module_file::serialize(parsed);
+
+			// write under a name of our own, then move it in place in one step
+			std::error_code error;
+			std::filesystem::path temporary = path;
+			temporary += '.' + std::to_string(std::random_device()()) + ".tmp";
+			{
+				std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+				if (file)
+					file.write(data.data(), std::streamsize(data.size()));
+
+				if (!file) {
+					file.close();
+					std::filesystem::remove(temporary, error);
+					return false;
+				}
+			}
+
+			std::filesystem::rename(temporary, path, error);
+			if (error) {
+				std::filesystem::remove(temporary, error);
+				return false;
+			}
+			return true;
+		}
+
+		std::string_view module_file::get_module(void) const noexcept {
+			return this->is_open() ? this->m_string(read<file_header>(this->m_file.data()).module) : std::string_view();
+		}
+
+		std::uint32_t module_file::get_global_use_count(void) const noexcept {
+			return this->is_open() ? read<file_header>(this->m_file.data()).global_uses : 0;
+		}
+
+		std::uint32_t module_file::get_use_count(void) const noexcept {
+			return this->is_open() ? read<file_header>(this->m_file.data()).sections[USES].count : 0;
+		}
+
+		std::uint32_t module_file::get_class_count(void) const noexcept {
+			return this->is_open() ? read<file_header>(this->m_file.data()).sections[CLASSES].count : 0;
+		}
+
+		std::string_view module_file::get_use(const std::uint32_t index) const noexcept {
+			const char* const record = this->m_record(USES, index);
+			return record ? this->m_string(read<std::uint32_t>(record)) : std::string_view();
+		}
+
+		module_file::class_entry module_file::get_class(const std::uint32_t index) const noexcept {
+			const char* const record = this->m_record(CLASSES, index);
+			if (!record)
+				return class_entry();
+
+			const class_record clazz = read<class_record>(record);
+			return { this->m_string(clazz.name), clazz.mods, clazz.global_uses, clazz.uses, clazz.functions, clazz.variables };
+		}
+
+		module_file::function_entry module_file::get_function(const std::uint32_t index) const noexcept {
+			const char* const record = this->m_record(FUNCTIONS, index);
+			if (!record)
+				return function_entry();
+
+			const function_record func = read<function_record>(record);
+			return { this->m_string(func.name), func.mods, { this->m_string(func.return_type.name), func.return_type.mods }, func.parameters };
+		}
+
+		module_file::parameter_entry module_file::get_parameter(const std::uint32_t index) const noexcept {
+			const char* const record = this->m_record(PARAMETERS, index);
+			if (!record)
+				return parameter_entry();
+
+			const parameter_record param = read<parameter_record>(record);
+			return { { this->m_string(param.type.name), param.type.mods }, this->m_string(param.name) };
+		}
+
+		module_file::variable_entry module_file::get_variable(const std::uint32_t index) const noexcept {
+			const char* const record = this->m_record(VARIABLES, index);
+			if (!record)
+				return variable_entry();
+
+			const variable_record variable = read<variable_record>(record);
+			return { this->m_string(variable.name), { this->m_string(variable.type.name), variable.type.mods } };
+		}
+
+		std::uint32_t module_file::find_class(const std::string_view name) const noexcept {
+			const std::uint32_t count = this->get_class_count();
+			for (std::uint32_t index = 0; index < count; index++) {
+				if (this->m_string(read<class_record>(this->m_record(CLASSES, index)).name) == name)
+					return index;
+			}
+			return npos;
+		}
+
+		const char* module_file::m_record(const std::size_t section, const std::uint32_t index) const noexcept {
+			if (!this->is_open())
+				return nullptr;
+
+			const file_header header = read<file_header>(this->m_file.data());
+			if (index >= header.sections[section].count)
+				return nullptr;
+			return this->m_file.data() + header.sections[section].offset + std::size_t(index) * record_size[section];
+		}
+
+		std::string_view module_file::m_string(const std::uint32_t index) const noexcept {
+			const char* const record = this->m_record(STRINGS, index);
+			if (!record)
+				return std::string_view();
+
+			const string_record string = read<string_record>(record);
+			const section pool = read<file_header>(this->m_file.data()).sections[POOL];
+			if (std::uint64_t(string.offset) + string.length > pool.count)
+				return std::string_view();
+			return std::string_view(this->m_file.data() + pool.offset + string.offset, string.length);
+		}
+	}
+}
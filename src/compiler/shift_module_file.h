@@ -0,0 +1,133 @@
+/**
+ * @file compiler/shift_module_file.h
+ *
+ * Binary module files (.shm), holding the declarations of a parsed source file
+ */
+#ifndef SHIFT_MODULE_FILE_H_
+#define SHIFT_MODULE_FILE_H_ 1
+
+#include "shift_config.h"
+#include "filesystem/file.h"
+#include "filesystem/mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		class parser;
+
+		/**
+		 * Memory-mapped module file.
+		 *
+		 * A module file holds the module name, the use statements and the classes of a source file, with the signatures
+		 * of their functions and the types of their variables; function bodies and variable initializers are left out. It
+		 * is made of tables of fixed-size records that refer to each other by index, and of a pool of names, which are
+		 * stored once each. Nothing in the file depends on where it is mapped, so opening it only checks its header, and
+		 * records are decoded one at a time as they are asked for.
+		 *
+		 * Indices passed to the getters are not required to be valid: records out of range, like those of a damaged file,
+		 * read as empty.
+		 */
+		class module_file {
+		public:
+			/// Extension of module files
+			static constexpr std::string_view extension = ".shm";
+
+			/// Returned by find_class() when there is no such class
+			static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+			/// Half-open range of records of another table
+			struct range {
+				std::uint32_t first = 0, count = 0;
+			};
+
+			struct type_entry {
+				std::string_view name;
+				std::uint32_t mods = 0; // parser::mods
+			};
+
+			struct parameter_entry {
+				type_entry type;
+				std::string_view name; // empty for nameless parameters
+			};
+
+			struct function_entry {
+				std::string_view name;
+				std::uint32_t mods = 0; // parser::mods
+				type_entry return_type;
+				range parameters;
+			};
+
+			struct variable_entry {
+				std::string_view name;
+				type_entry type;
+			};
+
+			struct class_entry {
+				std::string_view name;
+				std::uint32_t mods = 0; // parser::mods
+				std::uint32_t global_uses = 0; // number of global use statements before the class
+				range uses, functions, variables;
+			};
+		public:
+			module_file(void) noexcept = default;
+			module_file(const module_file&) = delete;
+			module_file(module_file&&) noexcept = default;
+			~module_file() noexcept = default;
+
+			module_file& operator=(const module_file&) = delete;
+			module_file& operator=(module_file&&) noexcept = default;
+
+			/**
+			 * Maps a module file, releasing any previously opened one.
+			 * @return True if the file is a module file of this version, false otherwise (in which case nothing is open).
+			 */
+			bool open(const filesystem::file& file) noexcept;
+
+			inline void close(void) noexcept { this->m_file.close(); }
+			inline bool is_open(void) const noexcept { return this->m_file.is_open(); }
+
+			/**
+			 * Serializes the declarations held by a parser.
+			 * @return The contents of the module file.
+			 */
+			static std::string serialize(const parser& parsed);
+
+			/**
+			 * Writes the module file of a parser; the file is replaced in one step, so that it is never seen partially written.
+			 * @return True on success, false otherwise.
+			 */
+			static bool store(const parser& parsed, const std::filesystem::path& path);
+
+			std::string_view get_module(void) const noexcept;
+
+			/// The global use statements come first in the use table, followed by the use statements of each class
+			std::uint32_t get_global_use_count(void) const noexcept;
+			std::uint32_t get_use_count(void) const noexcept;
+			std::uint32_t get_class_count(void) const noexcept;
+
+			std::string_view get_use(std::uint32_t index) const noexcept;
+			class_entry get_class(std::uint32_t index) const noexcept;
+			function_entry get_function(std::uint32_t index) const noexcept;
+			parameter_entry get_parameter(std::uint32_t index) const noexcept;
+			variable_entry get_variable(std::uint32_t index) const noexcept;
+
+			/// Index of the first class named @a name, or npos if there is none
+			std::uint32_t find_class(std::string_view name) const noexcept;
+		private:
+			const char* m_record(std::size_t section, std::uint32_t index) const noexcept;
+			std::string_view m_string(std::uint32_t index) const noexcept;
+		private:
+			filesystem::mapped_file m_file;
+		};
+	}
+}
+
+#endif /* SHIFT_MODULE_FILE_H_ */
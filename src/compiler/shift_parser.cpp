@@ -2,41 +2,10 @@
 
 #include <cstring>
 #include <algorithm>
-
-#define SHIFT_PARSER_ERROR_PREFIX 				"error: " << std::filesystem::relative(this->m_tokenizer->get_file().get_path()).native() << ": " // std::filesystem::relative call every time probably isn't that optimal
-#define SHIFT_PARSER_WARNING_PREFIX 			"warning: " << std::filesystem::relative(this->m_tokenizer->get_file().get_path()).string() << ": " // std::filesystem::relative call every time probably isn't that optimal
-
-#define SHIFT_PARSER_ERROR_PREFIX_EXT_(__line__, __col__) "error: " << std::filesystem::relative(this->m_tokenizer->get_file().get_path()).string() << ":" << __line__ << ":" << __col__ << ": " // std::filesystem::relative call every time probably isn't that optimal
-#define SHIFT_PARSER_WARNING_PREFIX_EXT_(__line__, __col__) "warning: " << std::filesystem::relative(this->m_tokenizer->get_file().get_path()).string() << ":" << __line__ << ":" << __col__ << ": " // std::filesystem::relative call every time probably isn't that optimal
-
-#define SHIFT_PARSER_ERROR_PREFIX_EXT(__token) SHIFT_PARSER_ERROR_PREFIX_EXT_((__token).get_file_index().line, (__token).get_file_index().col)
-#define SHIFT_PARSER_WARNING_PREFIX_EXT(__token) SHIFT_PARSER_WARNING_PREFIX_EXT_((__token).get_file_index().line, (__token).get_file_index().col)
-
-#define SHIFT_PARSER_PRINT() this->m_error_handler->print_exit_clear()
-
-#define SHIFT_PARSER_WARNING(__WARN__) 			this->m_error_handler->stream() << SHIFT_PARSER_WARNING_PREFIX << __WARN__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::warning)
-#define SHIFT_PARSER_FATAL_WARNING(__WARN__) 		SHIFT_PARSER_WARNING(__WARN__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_WARNING_LOG(__WARN__) 		this->m_error_handler->stream() << __WARN__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::warning)
-#define SHIFT_PARSER_FATAL_WARNING_LOG(__WARN__)  SHIFT_PARSER_WARNING_LOG(__WARN__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_ERROR(__ERR__) 			this->m_error_handler->stream() << SHIFT_PARSER_ERROR_PREFIX << __ERR__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::error)
-#define SHIFT_PARSER_FATAL_ERROR(__ERR__) 		SHIFT_PARSER_ERROR(__ERR__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_ERROR_LOG(__ERR__) 		this->m_error_handler->stream() << __ERR__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::error)
-#define SHIFT_PARSER_FATAL_ERROR_LOG(__ERR__)  SHIFT_PARSER_ERROR_LOG(__ERR__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_WARNING_(__token, __WARN__) 	this->m_error_handler->stream() << SHIFT_PARSER_WARNING_PREFIX_EXT(__token) << __WARN__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::warning)
-#define SHIFT_PARSER_FATAL_WARNING_(__token, __WARN__) 		SHIFT_PARSER_WARNING(__token, __WARN__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_WARNING_LOG_(__token, __WARN__) 		this->m_error_handler->stream() << __WARN__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::warning)
-#define SHIFT_PARSER_FATAL_WARNING_LOG_(__token, __WARN__)  SHIFT_PARSER_WARNING_LOG_(__token, __WARN__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_ERROR_(__token, __ERR__) 			this->m_error_handler->stream() << SHIFT_PARSER_ERROR_PREFIX_EXT(__token) << __ERR__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::error)
-#define SHIFT_PARSER_FATAL_ERROR_(__token, __ERR__) 		SHIFT_PARSER_ERROR_(__token, __ERR__); SHIFT_PARSER_PRINT()
-
-#define SHIFT_PARSER_ERROR_LOG_(__token, __ERR__) 		this->m_error_handler->stream() << __ERR__ << '\n'; this->m_error_handler->flush_stream(shift::compiler::error_handler::message_type::error)
-#define SHIFT_PARSER_FATAL_ERROR_LOG_(__token, __ERR__)  SHIFT_PARSER_ERROR_LOG_(__token, __ERR__); SHIFT_PARSER_PRINT()
+#include <exception>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #define SHIFT_PARSER_OBJECT_CLASS "shift.object"
 
@@ -87,13 +56,13 @@ namespace shift {
     namespace compiler {
         using token_type = token::token_type;
 
-        static constexpr inline bool is_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_overload_operator(); }
-        static constexpr inline bool is_binary_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_binary_operator(); }
-        static constexpr inline bool is_unary_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_unary_operator(); }
-        static constexpr inline bool is_prefix_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_prefix_overload_operator(); }
-        static constexpr inline bool is_suffix_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_suffix_overload_operator(); }
-        static constexpr inline bool is_strictly_prefix_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_strictly_prefix_overload_operator(); }
-        static constexpr inline bool is_strictly_suffix_operator(const token_type type) noexcept { return token(std::string_view(), type, file_indexer()).is_strictly_suffix_overload_operator(); }
+        static constexpr inline bool is_operator(const token_type type) noexcept { return token(std::string_view(), type).is_overload_operator(); }
+        static constexpr inline bool is_binary_operator(const token_type type) noexcept { return token(std::string_view(), type).is_binary_operator(); }
+        static constexpr inline bool is_unary_operator(const token_type type) noexcept { return token(std::string_view(), type).is_unary_operator(); }
+        static constexpr inline bool is_prefix_operator(const token_type type) noexcept { return token(std::string_view(), type).is_prefix_overload_operator(); }
+        static constexpr inline bool is_suffix_operator(const token_type type) noexcept { return token(std::string_view(), type).is_suffix_overload_operator(); }
+        static constexpr inline bool is_strictly_prefix_operator(const token_type type) noexcept { return token(std::string_view(), type).is_strictly_prefix_overload_operator(); }
+        static constexpr inline bool is_strictly_suffix_operator(const token_type type) noexcept { return token(std::string_view(), type).is_strictly_suffix_overload_operator(); }
         static constexpr parser::mods to_access_specifier(const token& token) noexcept;
 
         static constexpr parser::mods visibility_modifiers = parser::mods::PUBLIC | parser::mods::PROTECTED | parser::mods::PRIVATE;
@@ -103,14 +72,45 @@ namespace shift {
         static constexpr parser::mods constructor_modifiers = visibility_modifiers;
         static constexpr parser::mods variable_modifiers = visibility_modifiers | parser::mods::STATIC | parser::mods::CONST_ | parser::mods::EXTERN;
 
+        size_t parser::get_statement_size() noexcept { return arena_list<shift_statement>::node_size(); }
+
         void parser::parse() {
-            for (const token* current = &this->m_tokenizer->current_token(); !current->is_null_token(); current = &this->m_tokenizer->next_token()) {
+            const size_t threads = this->m_threads ? this->m_threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            if (threads > 1 && size_t(this->m_tokenizer->cend() - this->m_tokenizer->get_index()) >= parallel_min_tokens && m_parse_parallel(threads))
+                return;
+
+            m_parse_file(nullptr);
+        }
+
+        bool parser::m_parse_file(std::vector<class_span>* const spans) {
+            auto span = spans ? spans->begin() : std::vector<class_span>::iterator();
+
+            for (const token* current = &this->m_tokenizer->current_token(); !current->is_null_token() && !this->m_is_error_limit_reached(); current = &this->m_tokenizer->next_token()) {
                 if (current->is_use()) {
                     // use statement
                     m_parse_use();
                     continue;
                 }
 
+                if (current->is_class() && spans) {
+                    // leave the class to another thread, along with the state it is to be parsed in (see m_parse_parallel())
+                    const size_t index = size_t(this->m_tokenizer->get_index() - this->m_tokenizer->cbegin());
+                    while (span != spans->end() && span->begin < index)
+                        ++span;
+
+                    if (span == spans->end() || span->begin != index)
+                        return false; // a class the brackets did not tell apart, which could not be put in order with the others
+
+                    span->taken = true;
+                    span->mods.swap(this->m_mods);
+                    span->module_ = this->m_module;
+                    span->implicit_use_statements = this->m_global_uses.empty() ? nullptr : &this->m_global_uses.back();
+                    span->messages = this->m_error_handler ? this->m_error_handler->get_messages().size() : 0;
+                    this->m_tokenizer->set_index(span->end);
+                    ++span;
+                    continue;
+                }
+
                 if (current->is_class()) {
                     // creating class
                     m_parse_class();
@@ -133,13 +133,169 @@ namespace shift {
                     continue;
                 }
 
-                this->m_token_error(*current, "unexpected token '" + std::string(current->get_data()) + "'");
+                this->m_token_error(*current, "unexpected token '%'", current->get_data());
             }
 
             if (this->m_mods.size() > 0) {
                 const auto& [mod, token_] = this->m_mods.front();
-                this->m_token_error(*token_, "unexpected '" + std::string(token_->get_data()) + "' specifier");
+                this->m_token_error(*token_, "unexpected '%' specifier", token_->get_data());
+            }
+            return true;
+        }
+
+        bool parser::m_parse_parallel(const size_t threads) {
+            const std::vector<token>& tokens = this->m_tokenizer->get_tokens();
+            const auto start = this->m_tokenizer->get_index();
+
+            // top-level classes, found by matching brackets alone; whether the parser sees them the same way is only known
+            // once it reaches them
+            std::vector<class_span> spans;
+            for (size_t index = size_t(start - tokens.cbegin()), depth = 0, begin = size_t(-1); index < tokens.size(); index++) {
+                const token& token_ = tokens[index];
+                if (token_.is_left_scope_bracket()) {
+                    depth++;
+                } else if (token_.is_right_scope_bracket()) {
+                    if (depth > 0 && --depth == 0 && begin != size_t(-1)) {
+                        spans.emplace_back();
+                        spans.back().begin = std::exchange(begin, size_t(-1));
+                        spans.back().end = index;
+                    }
+                } else if (depth == 0 && token_.is_class()) {
+                    begin = index;
+                }
+            }
+
+            if (spans.size() < 2)
+                return false;
+
+            if (this->m_error_handler)
+                this->m_error_handler->mark();
+
+            // parse everything but the classes, noting down the state the parser was in at each of them
+            const bool ordered = m_parse_file(&spans);
+
+            std::vector<class_span*> taken;
+            size_t total = 0;
+            for (class_span& span : spans) {
+                if (span.taken) {
+                    taken.push_back(&span);
+                    total += span.end - span.begin + 1;
+                }
+            }
+
+            // the classes are split between the threads in runs of about as many tokens each
+            struct group {
+                size_t first = 0, last = 0; // indices into taken
+                arena arena;
+                arena_list<shift_class> classes;
+                size_t statements = 0;
+                std::exception_ptr exception;
+            };
+
+            std::vector<group> groups(ordered ? std::min(threads, taken.size()) : 0);
+            for (size_t index = 0, tokens_before = 0; index < taken.size() && !groups.empty(); index++) {
+                const size_t owner = std::min(tokens_before * groups.size() / total, groups.size() - 1);
+                if (groups[owner].last == 0)
+                    groups[owner].first = index;
+                groups[owner].last = index + 1;
+                tokens_before += taken[index]->end - taken[index]->begin + 1;
+            }
+
+            const std::shared_ptr<const error_handler::source_file> source_file = this->m_error_handler ? this->m_get_source_file() : nullptr;
+            const auto parse_group = [this, &tokens, &taken, &source_file](group& group) {
+                try {
+                    // each thread moves through a copy of the tokens of its own, whose tokens the tree is then pointed back from
+                    tokenizer copy(*this->m_tokenizer);
+                    parser worker(nullptr, &copy);
+                    worker.m_lazy_bodies = this->m_lazy_bodies;
+                    worker.m_source_file = source_file;
+
+                    const auto rebase = [&tokens, &copy](auto& ref) {
+                        if constexpr (std::is_pointer_v<std::decay_t<decltype(ref)>>) {
+                            if (ref && ref != &token::null)
+                                ref = tokens.data() + (ref - copy.get_tokens().data());
+                        } else if (ref != std::vector<token>::const_iterator()) {
+                            ref = tokens.cbegin() + (ref - copy.cbegin());
+                        }
+                    };
+
+                    for (size_t index = group.first; index < group.last; index++) {
+                        class_span& span = *taken[index];
+                        if (this->m_error_handler) {
+                            span.errors = this->m_error_handler->branch();
+                            worker.m_error_handler = &span.errors;
+                        }
+
+                        worker.m_mods.swap(span.mods);
+                        worker.m_module = span.module_;
+                        copy.set_index(span.begin);
+                        worker.m_parse_class();
+                        span.parsed = copy.get_index() == copy.cbegin() + span.end && worker.m_mods.empty();
+
+                        shift_class& clazz = worker.m_classes.back();
+                        clazz.module_ = &this->m_module;
+                        clazz.implicit_use_statements = span.implicit_use_statements;
+                        worker.m_visit_tokens(clazz, rebase);
+                        worker.m_clear_mods();
+                    }
+
+                    group.arena = std::move(worker.m_arena);
+                    group.classes = std::move(worker.m_classes);
+                    group.statements = worker.m_statement_count;
+                } catch (...) {
+                    group.exception = std::current_exception();
+                }
+            };
+
+            if (!groups.empty()) { // the first group is parsed on this thread
+                std::vector<std::thread> workers;
+                workers.reserve(groups.size() - 1);
+                for (size_t index = 1; index < groups.size(); index++)
+                    workers.emplace_back(parse_group, std::ref(groups[index]));
+
+                parse_group(groups.front());
+
+                for (std::thread& worker : workers)
+                    worker.join();
+            }
+
+            if (!ordered || !std::all_of(taken.cbegin(), taken.cend(), [](const class_span* const span) { return span->parsed; })) {
+                // start over, serially
+                this->m_arena.clear();
+                this->m_classes.clear();
+                this->m_global_uses.clear();
+                this->m_module = shift_module();
+                this->m_mods.clear();
+                this->m_operators.clear();
+                this->m_statement_count = 0;
+
+                if (this->m_error_handler)
+                    this->m_error_handler->rollback();
+                this->m_tokenizer->set_index(start);
+                return false;
+            }
+
+            for (group& group : groups) {
+                if (group.exception)
+                    std::rethrow_exception(group.exception);
+            }
+
+            for (group& group : groups) {
+                this->m_arena.merge(group.arena);
+                this->m_classes.splice_back_all(group.classes);
+                this->m_statement_count += group.statements;
+            }
+
+            if (this->m_error_handler) {
+                // the diagnostics of every class go where the parser would have reported them
+                std::vector<std::pair<size_t, error_handler*>> errors;
+                errors.reserve(taken.size());
+                for (class_span* const span : taken)
+                    errors.emplace_back(span->messages, &span->errors);
+                this->m_error_handler->insert(errors);
+                this->m_error_handler->pop_mark();
             }
+            return true;
         }
 
         void parser::m_parse_class(void) {
@@ -153,10 +309,10 @@ namespace shift {
                 this->m_token_error(class_token, "module must first be defined");
             }
 
-            m_classes.emplace_back();
+            m_classes.emplace_back(this->m_arena);
             shift_class& clazz = m_classes.back();
 
-            clazz.implicit_use_statements = --this->m_global_uses.cend();
+            clazz.implicit_use_statements = this->m_global_uses.empty() ? nullptr : &this->m_global_uses.back();
             clazz.module_ = &this->m_module;
 
             for (const token* access_specifier_token = &this->m_tokenizer->next_token(); access_specifier_token->is_access_specifier(); access_specifier_token = &this->m_tokenizer->next_token()) {
@@ -165,7 +321,7 @@ namespace shift {
 
             for (const auto& [mod, token_] : this->m_mods) {
                 if ((mod & class_modifiers) == 0) {
-                    this->m_token_error(*token_, "unexpected '" + std::string(token_->get_data()) + "' specifier in class declaration");
+                    this->m_token_error(*token_, "unexpected '%' specifier in class declaration", token_->get_data());
                 } else {
                     clazz.mods |= mod;
                 }
@@ -183,7 +339,7 @@ namespace shift {
                     return;
                 }
             } else if (clazz.name->is_keyword()) {
-                this->m_token_error(*clazz.name, "invalid class name '" + std::string(clazz.name->get_data()) + "'");
+                this->m_token_error(*clazz.name, "invalid class name '%'", clazz.name->get_data());
                 this->m_skip_before(token::token_type::LEFT_SCOPE_BRACKET);
             }
 
@@ -214,13 +370,15 @@ namespace shift {
 
             if (this->m_mods.size() > 0) {
                 const auto& [mod, token_] = this->m_mods.front();
-                this->m_token_error(*token_, "unexpected '" + std::string(token_->get_data()) + "' specifier inside class");
+                this->m_token_error(*token_, "unexpected '%' specifier inside class", token_->get_data());
                 this->m_clear_mods();
             }
         }
 
         void parser::m_parse_class(shift_class& clazz) {
-            for (const token* token_ = &this->m_tokenizer->current_token(); !token_->is_null_token(); token_ = &this->m_tokenizer->next_token()) {
+            clazz.body = this->m_tokenizer->get_index();
+
+            for (const token* token_ = &this->m_tokenizer->current_token(); !token_->is_null_token() && !this->m_is_error_limit_reached(); token_ = &this->m_tokenizer->next_token()) {
                 if (token_->is_access_specifier()) {
                     this->m_parse_access_specifier();
                     continue;
@@ -239,7 +397,7 @@ namespace shift {
 
                     for (const auto& [mod, token_] : this->m_mods) {
                         if ((mod & constructor_modifiers) == 0x0) {
-                            this->m_token_error(*token_, "unexpected '" + std::string(token_->get_data()) + "' specifier in constructor declaration");
+                            this->m_token_error(*token_, "unexpected '%' specifier in constructor declaration", token_->get_data());
                         } else {
                             func.mods |= mod;
                         }
@@ -263,12 +421,12 @@ namespace shift {
                         const token& param_name = this->m_tokenizer->current_token();
 
                         if (param_type.name.size() == 0) {
-                            this->m_token_error(*param_type.name.begin, "expected parameter type in constructor parameter list, got '" + std::string(param_type.name.begin->get_data()) + "'");
+                            this->m_token_error(*param_type.name.begin, "expected parameter type in constructor parameter list, got '%'", param_type.name.begin->get_data());
                         }
 
                         if (param_name.is_comma() || param_name.is_right_bracket()) {
                             // nameless parameters
-                            func.parameters.push_back({ std::move(param_type), &token::null });
+                            func.parameters.push_back(this->m_arena, { std::move(param_type), &token::null });
 
                             if (param_name.is_right_bracket())
                                 break;
@@ -283,10 +441,10 @@ namespace shift {
                                 this->m_token_error(this->m_tokenizer->reverse_peek_token(), "expected identifier for constructor parameter name before end of file");
                             }
                         } else if (param_name.is_keyword()) {
-                            this->m_token_error(param_name, "'" + std::string(param_name.get_data()) + "' is not a valid constructor parameter name");
+                            this->m_token_error(param_name, "'%' is not a valid constructor parameter name", param_name.get_data());
                         }
 
-                        func.parameters.push_back({ std::move(param_type), &param_name });
+                        func.parameters.push_back(this->m_arena, { std::move(param_type), &param_name });
 
                         const token& after_param_name = this->m_tokenizer->next_token();
                         if (!after_param_name.is_comma()) {
@@ -340,7 +498,7 @@ namespace shift {
                         }
                     }
 
-                    clazz.functions.push_back(std::move(func));
+                    clazz.functions.push_back(this->m_arena, std::move(func));
                     continue;
                 }
 
@@ -386,7 +544,7 @@ namespace shift {
                         if (name->is_constructor() && type.name.size() != 0) {
                             this->m_token_error(*type.name.begin, "class constructor cannot have return type");
                         } else {
-                            this->m_token_error(*name, "'" + std::string(name->get_data()) + "' is not a valid variable or function name");
+                            this->m_token_error(*name, "'%' is not a valid variable or function name", name->get_data());
                         }
                         name = &this->m_tokenizer->current_token();
                     }
@@ -403,13 +561,13 @@ namespace shift {
                             if ((mod & function_modifiers) == 0x0) {
                                 if ((mod & type_modifiers) != 0) {
                                     if (func.return_type.name.size() != 0 && func.return_type.name.begin->is_void()) {
-                                        this->m_token_error(*token_, "void returning function cannot have '" + std::string(token_->get_data()) + "' specifier");
+                                        this->m_token_error(*token_, "void returning function cannot have '%' specifier", token_->get_data());
                                     } else {
                                         func.return_type.mods |= mod;
                                     }
 
                                 } else {
-                                    this->m_token_error(*token_, "unexpected '" + std::string(token_->get_data()) + "' specifier in function declaration");
+                                    this->m_token_error(*token_, "unexpected '%' specifier in function declaration", token_->get_data());
                                 }
 
                             } else {
@@ -424,12 +582,12 @@ namespace shift {
                             const token& param_name = this->m_tokenizer->current_token();
 
                             if (param_type.name.size() == 0) {
-                                this->m_token_error(*param_type.name.begin, "expected parameter type in function parameter list, got '" + std::string(param_type.name.begin->get_data()) + "'");
+                                this->m_token_error(*param_type.name.begin, "expected parameter type in function parameter list, got '%'", param_type.name.begin->get_data());
                             }
 
                             if (param_name.is_comma() || param_name.is_right_bracket()) {
                                 // nameless parameters
-                                func.parameters.push_back({ std::move(param_type), &token::null });
+                                func.parameters.push_back(this->m_arena, { std::move(param_type), &token::null });
 
                                 if (param_name.is_right_bracket())
                                     break;
@@ -444,10 +602,10 @@ namespace shift {
                                     this->m_token_error(this->m_tokenizer->reverse_peek_token(), "expected identifier for function parameter name before end of file");
                                 }
                             } else if (param_name.is_keyword()) {
-                                this->m_token_error(param_name, "'" + std::string(param_name.get_data()) + "' is not a valid function parameter name");
+                                this->m_token_error(param_name, "'%' is not a valid function parameter name", param_name.get_data());
                             }
 
-                            func.parameters.push_back({ std::move(param_type), &param_name });
+                            func.parameters.push_back(this->m_arena, { std::move(param_type), &param_name });
 
                             const token& after_param_name = this->m_tokenizer->next_token();
                             if (!after_param_name.is_comma()) {
@@ -499,7 +657,7 @@ namespace shift {
                             }
                         }
 
-                        clazz.functions.push_back(std::move(func));
+                        clazz.functions.push_back(this->m_arena, std::move(func));
                     } else if (next_token.is_semicolon() || next_token.is_binary_operator() || next_token.is_unary_operator()) {
                         if(token_->is_void()) {
                             this->m_token_error(*token_, "'void' is not a valid variable type");
@@ -513,7 +671,7 @@ namespace shift {
 
                         for (const auto& [mod, token_] : this->m_mods) {
                             if ((mod & variable_modifiers) == 0x0) {
-                                this->m_token_error(*token_, "invalid '" + std::string(token_->get_data()) + "' specifier on variable");
+                                this->m_token_error(*token_, "invalid '%' specifier on variable", token_->get_data());
                             } else {
                                 variable.type.mods |= mod;
                             }
@@ -522,7 +680,7 @@ namespace shift {
 
                         if (next_token.is_binary_operator() || next_token.is_unary_operator()) {
                             if (!next_token.is_equals()) {
-                                this->m_token_error(next_token, "expected ';' or '=' for variable declaration, got '" + std::string(next_token.get_data()) + "'");
+                                this->m_token_error(next_token, "expected ';' or '=' for variable declaration, got '%'", next_token.get_data());
                             }
 
                             // variable definition
@@ -534,7 +692,7 @@ namespace shift {
                             }
                         }
 
-                        clazz.variables.push_back(std::move(variable));
+                        clazz.variables.push_back(this->m_arena, std::move(variable));
                     } else {
                         this->m_token_error(next_token, "expected either variable or function declaration");
                     }
@@ -543,14 +701,310 @@ namespace shift {
 
                 if (token_->is_right_scope_bracket()) break;
             }
+
+            clazz.body_end = this->m_tokenizer->get_index();
+        }
+
+        void parser::parse_bodies() {
+            for (shift_class& clazz : this->m_classes) {
+                for (shift_function& func : clazz.functions)
+                    m_get_statements(func);
+            }
         }
 
         void parser::m_parse_function(shift_function& func) {
-            return m_parse_function_block(func, func.statements);
+            func.body = this->m_tokenizer->get_index();
+            func.standalone = this->m_lazy_bodies || this->m_mods.empty(); // lazy bodies are always parsed on their own
+
+            if (!this->m_lazy_bodies) {
+                m_parse_function_block(func, func.statements);
+            } else if (!this->m_match_closing(token::token_type::LEFT_SCOPE_BRACKET)) {
+                // a body still open at the end of the file is parsed right away, so that it is diagnosed as usual
+                this->m_tokenizer->set_index(func.body);
+                m_parse_function_block(func, func.statements);
+            } else {
+                func.lazy = true;
+            }
+
+            func.body_end = this->m_tokenizer->get_index();
+        }
+
+        arena_list<parser::shift_statement>& parser::m_get_statements(shift_function& func) {
+            if (!func.lazy)
+                return func.statements;
+            func.lazy = false;
+
+            // parse the body from its first token, and then carry on from wherever parsing was
+            const auto index = this->m_tokenizer->get_index();
+            std::list<std::pair<mods, const token*>> outer_mods;
+            outer_mods.swap(this->m_mods);
+
+            this->m_tokenizer->set_index(func.body);
+            m_parse_function_block(func, func.statements);
+            func.body_end = std::max(func.body_end, this->m_tokenizer->get_index()); // the body may have read past the '}' it was skipped to
+
+            this->m_tokenizer->set_index(index);
+            this->m_mods.swap(outer_mods);
+            return func.statements;
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(F&& visit) {
+            m_visit_tokens(this->m_module, visit);
+            for (shift_module& use : this->m_global_uses)
+                m_visit_tokens(use, visit);
+            for (shift_class& clazz : this->m_classes)
+                m_visit_tokens(clazz, visit);
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(shift_name& name, F& visit) {
+            visit(name.begin);
+            visit(name.end);
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(shift_type& type, F& visit) { m_visit_tokens(type.name, visit); }
+
+        template<typename F>
+        void parser::m_visit_tokens(shift_expression& expr, F& visit) {
+            // expressions may nest very deep, so they are walked with a stack; m_operators is not in use outside of m_parse_expression()
+            const size_t operators_begin = this->m_operators.size();
+            this->m_operators.push_back(&expr);
+
+            while (this->m_operators.size() > operators_begin) {
+                shift_expression& next = *this->m_operators.back();
+                this->m_operators.pop_back();
+
+                visit(next.begin);
+                visit(next.end);
+                for (shift_expression& sub : next.sub)
+                    this->m_operators.push_back(&sub);
+            }
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(shift_variable& variable, F& visit) {
+            m_visit_tokens(variable.type, visit);
+            visit(variable.name);
+            m_visit_tokens(variable.value, visit);
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(arena_list<shift_statement>& statements, F& visit) {
+            for (shift_statement& statement : statements) {
+                std::visit([&](auto& data) {
+                    using data_type = std::decay_t<decltype(data)>;
+
+                    if constexpr (std::is_same_v<data_type, shift_statement::expression_data>) {
+                        m_visit_tokens(data.expr, visit);
+                    } else if constexpr (std::is_same_v<data_type, shift_statement::variable_data>) {
+                        m_visit_tokens(data.variable, visit);
+                    } else if constexpr (std::is_same_v<data_type, shift_statement::block_data>) {
+                        visit(data.begin);
+                        visit(data.end);
+                    } else if constexpr (std::is_same_v<data_type, shift_statement::use_data>) {
+                        visit(data.token);
+                        m_visit_tokens(data.module_, visit);
+                    } else if constexpr (std::is_same_v<data_type, shift_statement::keyword_data>) {
+                        visit(data.token);
+                        m_visit_tokens(data.expr, visit);
+                    } else if constexpr (std::is_same_v<data_type, shift_statement::for_data>) {
+                        visit(data.token);
+                        m_visit_tokens(data.condition, visit);
+                        m_visit_tokens(data.increment, visit);
+                    } else if constexpr (std::is_same_v<data_type, shift_statement::jump_data>) {
+                        visit(data.token);
+                    }
+                }, statement.data);
+
+                m_visit_tokens(statement.sub, visit);
+            }
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(shift_function& func, F& visit) {
+            visit(func.name);
+            m_visit_tokens(func.return_type, visit);
+            for (auto& [param_type, param_name] : func.parameters) {
+                m_visit_tokens(param_type, visit);
+                visit(param_name);
+            }
+            m_visit_tokens(func.statements, visit);
+            visit(func.body);
+            visit(func.body_end);
+        }
+
+        template<typename F>
+        void parser::m_visit_tokens(shift_class& clazz, F& visit) {
+            visit(clazz.name);
+            for (shift_module& use : clazz.use_statements)
+                m_visit_tokens(use, visit);
+            for (shift_function& func : clazz.functions)
+                m_visit_tokens(func, visit);
+            for (shift_variable& variable : clazz.variables)
+                m_visit_tokens(variable, visit);
+            visit(clazz.body);
+            visit(clazz.body_end);
+        }
+
+        parser::reparse_scope parser::edit(const size_t offset, const size_t removed, const std::string_view inserted) {
+            constexpr size_t npos = size_t(-1);
+            const std::vector<token>& tokens = this->m_tokenizer->get_tokens();
+
+            const auto index_of = [&tokens](const auto& ref) -> size_t {
+                if constexpr (std::is_pointer_v<std::decay_t<decltype(ref)>>) {
+                    return ref && ref != &token::null ? size_t(ref - tokens.data()) : npos;
+                } else {
+                    return ref != std::vector<token>::const_iterator() ? size_t(ref - tokens.cbegin()) : npos;
+                }
+            };
+
+            // The tree points into the token list, which the edit may move, so every token it refers to is noted down by index
+            // first. So are the tokens read by the body of every function and class, any of which may be parsed on its own.
+            struct unit {
+                shift_class* clazz;
+                shift_function* func; // null for the members of a class
+                size_t open, close; // the token before the body, and the one it ended at
+                bool standalone; // whether the body is enclosed in '{' and '}', and can be parsed on its own
+            };
+
+            std::vector<size_t>& indices = this->m_token_indices;
+            std::vector<unit> units;
+            indices.clear();
+            const size_t position = index_of(this->m_tokenizer->get_index());
+
+            this->m_visit_tokens([&](const auto& ref) { indices.push_back(index_of(ref)); });
+
+            const auto add_unit = [&](shift_class& clazz, shift_function* const func, const auto body, const auto body_end, const bool standalone) {
+                const size_t open = index_of(body), close = index_of(body_end);
+                if (open != npos && open > 0 && close != npos) {
+                    units.push_back({ &clazz, func, open - 1, close, standalone && close < tokens.size() && tokens[open - 1].is_left_scope_bracket()
+                        && tokens[close].is_right_scope_bracket() });
+                }
+            };
+
+            for (shift_class& clazz : this->m_classes) {
+                add_unit(clazz, nullptr, clazz.body, clazz.body_end, true);
+                for (shift_function& func : clazz.functions)
+                    add_unit(clazz, &func, func.body, func.body_end, func.standalone);
+            }
+
+            // the diagnostics so far point into the source the edit is about to change
+            if (this->m_error_handler)
+                this->m_error_handler->format();
+
+            const tokenizer::token_range range = this->m_tokenizer->edit(offset, removed, inserted);
+            const auto moved = [&range](const size_t index) {
+                if (index < range.begin) return index;
+                if (index < range.begin + range.removed) return range.begin; // replaced; only ever part of what is parsed again
+                return index - range.removed + range.inserted;
+            };
+
+            size_t next = 0;
+            this->m_visit_tokens([&](auto& ref) {
+                const size_t index = indices[next++];
+                if (index == npos) return;
+
+                if constexpr (std::is_pointer_v<std::decay_t<decltype(ref)>>) {
+                    ref = &tokens[moved(index)];
+                } else {
+                    ref = tokens.cbegin() + moved(index);
+                }
+            });
+
+            reparse_scope scope = reparse_scope::none;
+            if (range.removed != 0 || range.inserted != 0) {
+                const auto holds = [&range](const unit& unit) {
+                    return range.begin + range.removed <= unit.close + 1 && (range.begin > unit.open || (range.begin == unit.open && range.removed != 0));
+                };
+                const auto reads = [&range](const unit& unit) { return range.begin <= unit.close && range.begin + std::max<size_t>(range.removed, 1) > unit.open; };
+
+                // A body can only be parsed again on its own if no other one read the tokens the edit replaced; a body that did
+                // not end at its '}' may have read past it, such as a lazy one parsed after the rest of the file.
+                const auto reparse = [&](const unit* const unit) {
+                    const bool alone = unit && unit->standalone && holds(*unit) && std::none_of(units.cbegin(), units.cend(), [&](const struct unit& other) {
+                        const bool inside = unit->func ? other.func == unit->func || (!other.func && other.clazz == unit->clazz) : other.clazz == unit->clazz;
+                        return !inside && reads(other);
+                    });
+                    return alone && this->m_reparse(*unit->clazz, unit->func, unit->open, unit->close - range.removed + range.inserted);
+                };
+
+                // units are listed outermost first, so the last one holding the edit is the innermost
+                const auto innermost = std::find_if(units.crbegin(), units.crend(), holds);
+                const auto outer = innermost == units.crend() ? units.crend()
+                    : std::find_if(innermost, units.crend(), [&innermost](const unit& unit) { return !unit.func && unit.clazz == innermost->clazz; });
+
+                if (innermost != units.crend() && innermost->func && reparse(&*innermost)) {
+                    scope = reparse_scope::function;
+                } else if (outer != units.crend() && reparse(&*outer)) {
+                    scope = reparse_scope::class_;
+                } else {
+                    // nothing smaller holds the edit, so the file is parsed from scratch
+                    this->m_arena.clear();
+                    this->m_classes.clear();
+                    this->m_global_uses.clear();
+                    this->m_module = shift_module();
+                    this->m_clear_mods();
+                    this->m_operators.clear();
+                    this->m_statement_count = 0;
+
+                    this->m_tokenizer->set_index(this->m_tokenizer->cbegin());
+                    this->parse();
+                    return reparse_scope::file;
+                }
+            }
+
+            this->m_tokenizer->set_index(position == npos ? tokens.size() : std::min(moved(position), tokens.size()));
+            return scope;
+        }
+
+        bool parser::m_reparse(shift_class& clazz, shift_function* const func, const size_t open, const size_t close) {
+            const std::vector<token>& tokens = this->m_tokenizer->get_tokens();
+            if (close >= tokens.size() || !tokens[open].is_left_scope_bracket() || !tokens[close].is_right_scope_bracket())
+                return false;
+
+            // what came before the body is unchanged, so the body is parsed as it would be within the whole file; if it now
+            // ends anywhere else than at its old '}', the rest of the file would be parsed differently as well
+            if (this->m_error_handler)
+                this->m_error_handler->mark();
+
+            std::list<std::pair<mods, const token*>> outer_mods;
+            outer_mods.swap(this->m_mods);
+            this->m_tokenizer->set_index(open + 1);
+
+            if (func) {
+                func->statements.clear();
+                func->lazy = false;
+                m_parse_function(*func);
+            } else {
+                clazz.use_statements.clear();
+                clazz.functions.clear();
+                clazz.variables.clear();
+                m_parse_class(clazz);
+
+                if (this->m_mods.size() > 0) {
+                    const auto& [mod, token_] = this->m_mods.front();
+                    this->m_token_error(*token_, "unexpected '%' specifier inside class", token_->get_data());
+                    this->m_clear_mods();
+                }
+            }
+
+            this->m_mods.swap(outer_mods);
+            const bool reparsed = this->m_tokenizer->get_index() == tokens.cbegin() + close;
+
+            if (this->m_error_handler) {
+                if (reparsed)
+                    this->m_error_handler->pop_mark();
+                else
+                    this->m_error_handler->rollback();
+            }
+            return reparsed;
         }
 
-        void parser::m_parse_function_block(shift_function& func, std::list<shift_statement>& statements, size_t count) {
-            for (const token* _token = &this->m_tokenizer->current_token(); count != 0 && !_token->is_null_token(); _token = &this->m_tokenizer->next_token(), count--) {
+        void parser::m_parse_function_block(shift_function& func, arena_list<shift_statement>& statements, size_t count) {
+            for (const token* _token = &this->m_tokenizer->current_token(); count != 0 && !_token->is_null_token() && !this->m_is_error_limit_reached();
+                _token = &this->m_tokenizer->next_token(), count--) {
                 shift_statement statement;
 
                 if (_token->is_access_specifier()) {
@@ -569,7 +1023,7 @@ namespace shift {
                 else if (_token->is_if()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
                     statement.set_if(_token);
@@ -620,10 +1074,10 @@ namespace shift {
                 else if (_token->is_else()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
-                    if (statements.size() == 0 || statements.back().type != shift_statement::statement_type::if_) {
+                    if (statements.size() == 0 || statements.back().get_type() != shift_statement::statement_type::if_) {
                         this->m_token_error(*_token, "unexpected 'else' statement in function body");
                     }
 
@@ -655,7 +1109,7 @@ namespace shift {
                 else if (_token->is_while()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
                     statement.set_while(_token);
@@ -706,7 +1160,7 @@ namespace shift {
                 else if (_token->is_for()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
                     statement.set_for(_token);
@@ -724,11 +1178,11 @@ namespace shift {
                     {
                         this->m_tokenizer->next_token(); // Move onto statement token
 
-                        std::list<shift_statement> temp_statement;
+                        arena_list<shift_statement> temp_statement;
                         m_parse_function_block(func, temp_statement, 1);
                         if (temp_statement.size() > 0)
                             // TODO add statement type checking
-                            statement.set_for_initializer(std::move(temp_statement.front()));
+                            statement.set_for_initializer(this->m_arena, std::move(temp_statement.front()));
                     }
 
                     {
@@ -775,7 +1229,7 @@ namespace shift {
                 else if (_token->is_return()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
                     statement.set_return(_token);
@@ -786,7 +1240,7 @@ namespace shift {
                 else if (_token->is_continue() || _token->is_break()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
                     if (_token->is_continue())
@@ -798,10 +1252,10 @@ namespace shift {
 
                     if (!semi_colon.is_semicolon()) {
                         if (!semi_colon.is_null_token()) {
-                            this->m_token_error(semi_colon, "expected ';' after '" + std::string(_token->get_data()) + "' in function body");
+                            this->m_token_error(semi_colon, "expected ';' after '%' in function body", _token->get_data());
                             this->m_skip_until(token::token_type::SEMICOLON);
                         } else {
-                            this->m_token_error(this->m_tokenizer->reverse_peek_token(), "expected ';' after '" + std::string(_token->get_data()) + "' in function body before end of file");
+                            this->m_token_error(this->m_tokenizer->reverse_peek_token(), "expected ';' after '%' in function body before end of file", _token->get_data());
                         }
                     }
                 }
@@ -824,7 +1278,7 @@ namespace shift {
                         statement.set_variable();
 
                         if (after_type.is_keyword()) {
-                            this->m_token_error(after_type, "'" + std::string(after_type.get_data()) + "' is not a valid variable name");
+                            this->m_token_error(after_type, "'%' is not a valid variable name", after_type.get_data());
                         }
 
                         shift_variable variable;
@@ -834,7 +1288,7 @@ namespace shift {
 
                         for (const auto& [mod, token_] : this->m_mods) {
                             if ((mod & variable_modifiers) == 0x0) {
-                                this->m_token_error(*token_, "invalid '" + std::string(token_->get_data()) + "' specifier on variable");
+                                this->m_token_error(*token_, "invalid '%' specifier on variable", token_->get_data());
                             } else {
                                 variable.type.mods |= mod;
                             }
@@ -845,7 +1299,7 @@ namespace shift {
 
                         if (next_token.is_binary_operator() || next_token.is_unary_operator()) {
                             if (!next_token.is_equals()) {
-                                this->m_token_error(next_token, "expected ';' or '=' for variable declaration, got '" + std::string(next_token.get_data()) + "'");
+                                this->m_token_error(next_token, "expected ';' or '=' for variable declaration, got '%'", next_token.get_data());
                             }
                             // variable definition
                             const token& first_expr_token = this->m_tokenizer->next_token(); // Move onto the expression
@@ -856,9 +1310,9 @@ namespace shift {
                             }
                         } else if (!next_token.is_semicolon()) {
                             if (!next_token.is_null_token()) {
-                                this->m_token_error(next_token, "expected ';' or '=' for variable declaration, got '" + std::string(next_token.get_data()) + "'");
+                                this->m_token_error(next_token, "expected ';' or '=' for variable declaration, got '%'", next_token.get_data());
                             } else {
-                                this->m_token_error(this->m_tokenizer->reverse_peek_token(), "expected ';' or '=' for variable declaration before end of file, got '" + std::string(next_token.get_data()) + "'");
+                                this->m_token_error(this->m_tokenizer->reverse_peek_token(), "expected ';' or '=' for variable declaration before end of file, got '%'", next_token.get_data());
                             }
                             this->m_skip_until(token::token_type::SEMICOLON);
                         }
@@ -887,11 +1341,11 @@ namespace shift {
                 else if (_token->is_left_scope_bracket()) {
                     if (this->m_mods.size() != 0) {
                         const auto& [mod, token_] = this->m_mods.front();
-                        this->m_token_error(*token_, "unexpected specifier '" + std::string(token_->get_data()) + "' in function body");
+                        this->m_token_error(*token_, "unexpected specifier '%' in function body", token_->get_data());
                         this->m_clear_mods();
                     }
                     statement.set_block(_token);
-                    std::list<shift_statement> _statements;
+                    arena_list<shift_statement> _statements;
                     this->m_tokenizer->next_token();
                     m_parse_function_block(func, _statements);
                     statement.set_block(std::move(_statements));
@@ -912,13 +1366,14 @@ namespace shift {
                 }
 
 
-                statements.push_back(std::move(statement));
+                statements.push_back(this->m_arena, std::move(statement));
+                this->m_statement_count++;
             }
 
 
             if (this->m_mods.size() > 0) {
                 const auto& [mod, token_] = this->m_mods.front();
-                this->m_token_error(*token_, "unexpected '" + std::string(token_->get_data()) + "' specifier function body");
+                this->m_token_error(*token_, "unexpected '%' specifier function body", token_->get_data());
                 this->m_clear_mods();
             }
         }
@@ -927,7 +1382,7 @@ namespace shift {
             return m_parse_use(this->m_global_uses);
         }
 
-        void parser::m_parse_use(std::list<shift_module>& modules) {
+        void parser::m_parse_use(arena_list<shift_module>& modules) {
             // TODO warn if the module being used has already been included
             if (this->m_mods.size() > 0) {
                 this->m_token_error(*this->m_mods.front().second, "unexpected access specifier in 'use' declaration");
@@ -943,7 +1398,7 @@ namespace shift {
             }
 
             this->m_tokenizer->next_token(); // skip 'use' keyword
-            modules.push_back(m_parse_name("module name"));
+            modules.push_back(this->m_arena, m_parse_name("module name"));
 
             const token& end_token = this->m_tokenizer->current_token(); // token after the module name
             if (m_global_uses.back().size() == 0) {
@@ -952,7 +1407,7 @@ namespace shift {
             } else if (end_token.is_null_token()) {
                 this->m_token_error(this->m_tokenizer->reverse_token(), "expected ';' before end of file");
             } else if (!end_token.is_semicolon()) {
-                this->m_token_error(end_token, "unexpected '" + std::string(end_token.get_data()) + "' in module name");
+                this->m_token_error(end_token, "unexpected '%' in module name", end_token.get_data());
                 this->m_skip_until(token::token_type::SEMICOLON);
             }
         }
@@ -982,7 +1437,7 @@ namespace shift {
             } else if (end_token.is_null_token()) {
                 this->m_token_error(this->m_tokenizer->reverse_token(), "expected ';' before end of file");
             } else if (!end_token.is_semicolon()) {
-                this->m_token_error(end_token, "unexpected '" + std::string(end_token.get_data()) + "' in module name");
+                this->m_token_error(end_token, "unexpected '%' in module name", end_token.get_data());
                 this->m_skip_until(token::token_type::SEMICOLON);
             }
         }
@@ -997,12 +1452,12 @@ namespace shift {
 
             for (const token* token = &this->m_tokenizer->current_token(); !token->is_null_token(); token = &this->m_tokenizer->next_token()) {
                 if (token->is_access_specifier()) {
-                    this->m_token_error(*token, "unexpected '" + std::string(token->get_data()) + "' specifier in " + std::string(name_type));
+                    this->m_token_error(*token, "unexpected '%' specifier in %", token->get_data(), name_type);
                 }
 
                 else if (token->is_keyword()) {
                     // error, no keywords in (module) names
-                    this->m_token_error(*token, "invalid '" + std::string(token->get_data()) + "' inside " + std::string(name_type));
+                    this->m_token_error(*token, "invalid '%' inside %", token->get_data(), name_type);
                     last_type = token::token_type::IDENTIFIER;
                 }
 
@@ -1030,7 +1485,7 @@ namespace shift {
             name.end = this->m_tokenizer->get_index();
 
             if (last_type == token::token_type::DOT) {
-                this->m_token_error(this->m_tokenizer->reverse_peek_token(), "unexpected '.' inside " + std::string(name_type));
+                this->m_token_error(this->m_tokenizer->reverse_peek_token(), "unexpected '.' inside %", name_type);
             }
 
             return name;
@@ -1058,7 +1513,7 @@ namespace shift {
                         auto const mod = this->m_mods.back().first;
 
                         if ((mod & type_modifiers) == 0x0) {
-                            this->m_token_error(*token, "unexpected '" + std::string(token->get_data()) + "' specifier in " + std::string(name_type));
+                            this->m_token_error(*token, "unexpected '%' specifier in %", token->get_data(), name_type);
                         }
                         last_type = token::token_type::IDENTIFIER;
                     }
@@ -1069,7 +1524,7 @@ namespace shift {
 
                     else if (token->is_keyword()) {
                         // error, no keywords in (module) names
-                        this->m_token_error(*token, "invalid '" + std::string(token->get_data()) + "' inside " + std::string(name_type));
+                        this->m_token_error(*token, "invalid '%' inside %", token->get_data(), name_type);
                         last_type = token::token_type::IDENTIFIER;
                     }
 
@@ -1107,7 +1562,7 @@ namespace shift {
                 }
 
                 if (last_type == token::token_type::DOT) {
-                    this->m_token_error(this->m_tokenizer->reverse_peek_token(), "unexpected '.' inside " + std::string(name_type));
+                    this->m_token_error(this->m_tokenizer->reverse_peek_token(), "unexpected '.' inside %", name_type);
                 }
 
                 type.name = std::move(name);
@@ -1115,25 +1570,25 @@ namespace shift {
 
             for (const token* token = &this->m_tokenizer->current_token(); !token->is_null_token(); token = &this->m_tokenizer->next_token()) {
                 if (token->is_access_specifier()) {
-                    this->m_token_error(*token, "unexpected '" + std::string(token->get_data()) + "' specifier in " + std::string(name_type) + " type");
+                    this->m_token_error(*token, "unexpected '%' specifier in % type", token->get_data(), name_type);
                 }
 
                 else if (token->is_left_square_bracket()) {
                     if (last_type != token::token_type::IDENTIFIER && last_type != token::token_type::RIGHT_SQUARE_BRACKET) {
-                        this->m_token_error(*token, "unexpected '[' in " + std::string(name_type));
+                        this->m_token_error(*token, "unexpected '[' in %", name_type);
                     }
                     last_type = token::token_type::LEFT_SQUARE_BRACKET;
                 }
 
                 else if (token->is_right_square_bracket()) {
                     if (last_type != token::token_type::LEFT_SQUARE_BRACKET) {
-                        this->m_token_error(*token, "unexpected ']' in " + std::string(name_type));
+                        this->m_token_error(*token, "unexpected ']' in %", name_type);
                     }
                     last_type = token::token_type::RIGHT_SQUARE_BRACKET;
                 }
 
                 else if (last_type == token::token_type::LEFT_SQUARE_BRACKET) {
-                    this->m_token_error(*token, "expected ']' in " + std::string(name_type));
+                    this->m_token_error(*token, "expected ']' in %", name_type);
                     break;
                 } else break;
             }
@@ -1142,7 +1597,7 @@ namespace shift {
 
             if (last_type == token::token_type::LEFT_SQUARE_BRACKET) {
                 const token& last = this->m_tokenizer->reverse_peek_token();
-                this->m_token_error(last, "unexpected '[' inside " + std::string(name_type));
+                this->m_token_error(last, "unexpected '[' inside %", name_type);
             }
 
             return type;
@@ -1158,7 +1613,7 @@ namespace shift {
                 this->m_token_error(current_token, "unexpected visibility specifier");
             } else if ((current_mods & mod) == mod) {
                 // send a warning if we are just adding the same modifier twice
-                this->m_token_warning(current_token, "redundant '" + std::string(current_token.get_data()) + "' specifier");
+                this->m_token_warning(current_token, "redundant '%' specifier", current_token.get_data());
             } else {
                 this->m_add_mod(mod, current_token);
             }
@@ -1214,15 +1669,7 @@ namespace shift {
             if (bracket_type != token_type::LEFT_BRACKET && bracket_type != token_type::LEFT_SQUARE_BRACKET && bracket_type != token_type::LEFT_SCOPE_BRACKET)
                 return m_skip_until(bracket_type);
 
-            const token_type look = token_type(std::underlying_type_t<token_type>(bracket_type) + 1);
-
-            size_t count = 1;
-            for (const token* _token = &this->m_tokenizer->current_token(); !_token->is_null_token() && count > 0; _token = &this->m_tokenizer->next_token()) {
-                if (_token->get_token_type() == bracket_type) count++;
-                else if (_token->get_token_type() == look) count--;
-            }
-
-            if (count != 0) {
+            if (!m_match_closing(bracket_type)) {
                 const char* msg;
                 switch (bracket_type) {
                     case token::token_type::LEFT_BRACKET:
@@ -1242,13 +1689,32 @@ namespace shift {
                 this->m_token_error(this->m_tokenizer->reverse_peek_token(), msg);
             }
 
-            return this->m_tokenizer->current_token().is_null_token() ? this->m_tokenizer->current_token() : this->m_tokenizer->reverse_token();
+            return this->m_tokenizer->current_token();
+        }
+
+        bool parser::m_match_closing(const typename token::token_type bracket_type) noexcept {
+            const token_type look = token_type(std::underlying_type_t<token_type>(bracket_type) + 1);
+
+            // moves onto the bracket closing the one just before the current token, without reporting anything
+            size_t count = 1;
+            for (const token* _token = &this->m_tokenizer->current_token(); !_token->is_null_token(); _token = &this->m_tokenizer->next_token()) {
+                if (_token->get_token_type() == bracket_type) count++;
+                else if (_token->get_token_type() == look && --count == 0) return true;
+            }
+            return false;
         }
 
 
         parser::shift_expression parser::m_parse_expression(const token::token_type end_type) {
-            shift_expression ret_expr;
-            shift_expression* expr = &ret_expr;
+            // The expression is built in a single pass, allocating each node once. Every operator gets an operand on both sides,
+            // either of which may stay empty (the left one of prefix operators, the right one of suffix operators), and
+            // m_operators holds the operators and brackets on the path from the operand being filled up to the top of the
+            // expression. A new operator takes the place of the operand of the innermost of them it binds tighter than (or of
+            // the top of the expression) and links that operand in as its left one, so no subtree is ever moved.
+            arena_list<shift_expression> root; // holds the expression, so that operators can be put above it like above any operand
+            arena_list<shift_expression>* top = &root; // holds the top of the current comma-separated part of the expression
+            shift_expression* expr = &root.emplace_back(this->m_arena);
+            const size_t operators_begin = this->m_operators.size();
 
 
             for (const token* _token = &this->m_tokenizer->current_token(); !_token->is_null_token() && _token->get_token_type() != end_type; _token = &this->m_tokenizer->next_token()) {
@@ -1322,8 +1788,9 @@ namespace shift {
                     expr->begin = this->m_tokenizer->get_index();
                     expr->end = expr->begin + 1;
                     this->m_tokenizer->next_token(); // skip (
-                    expr->set_left(m_parse_expression(token::token_type::RIGHT_BRACKET));
-                    expr->set_right();
+                    expr->set_left(this->m_arena, m_parse_expression(token::token_type::RIGHT_BRACKET));
+                    expr->set_right(this->m_arena);
+                    this->m_operators.push_back(expr);
                     expr = expr->get_right();
                     const token& right_bracket = this->m_tokenizer->current_token();
                     if (!right_bracket.is_right_bracket()) {
@@ -1337,20 +1804,21 @@ namespace shift {
                         this->m_token_error(*_token, "unexpected ',' inside expression");
                     }
 
-                    if (ret_expr.type != token::token_type::COMMA) {
-                        shift_expression temp = std::move(ret_expr);
+                    if (root.back().type != token::token_type::COMMA) {
+                        arena_list<shift_expression> first;
+                        first.splice_back(root);
 
-                        ret_expr = shift_expression();
-                        ret_expr.type = token::token_type::COMMA;
-                        ret_expr.begin = this->m_tokenizer->get_index();
-                        ret_expr.end = ret_expr.begin + 1;
-
-                        ret_expr.sub.push_back(std::move(temp));
+                        shift_expression& comma = root.emplace_back(this->m_arena);
+                        comma.type = token::token_type::COMMA;
+                        comma.begin = this->m_tokenizer->get_index();
+                        comma.end = comma.begin + 1;
+                        comma.sub.splice_back(first);
+                        top = &comma.sub;
                     }
 
-                    ret_expr.sub.back().parent = &ret_expr;
-                    ret_expr.sub.emplace_back();
-                    expr = &ret_expr.sub.back();
+                    top->back().parent = &root.back();
+                    expr = &top->emplace_back(this->m_arena);
+                    this->m_operators.resize(operators_begin);
 
                     continue;
                 }
@@ -1358,55 +1826,53 @@ namespace shift {
                 if (_token->is_binary_operator() || _token->is_unary_operator()) {
                     if (_token->is_binary_operator()) {
                         if (expr->type == token::token_type::NULL_TOKEN && !_token->is_prefix_overload_operator()) {
-                            this->m_token_error(*_token, "unexpected operator '" + std::string(_token->get_data()) + "' inside expression");
+                            this->m_token_error(*_token, "unexpected operator '%' inside expression", _token->get_data());
                         }
                     } else {
                         if (expr->type == token::token_type::NULL_TOKEN) {
                             if (_token->is_strictly_suffix_overload_operator()) {
-                                this->m_token_error(*_token, "unexpected operator '" + std::string(_token->get_data()) + "' inside expression");
+                                this->m_token_error(*_token, "unexpected operator '%' inside expression", _token->get_data());
                             }
                         } else {
                             if (_token->is_strictly_prefix_overload_operator()) {
-                                this->m_token_error(*_token, "unexpected operator '" + std::string(_token->get_data()) + "' inside expression");
+                                this->m_token_error(*_token, "unexpected operator '%' inside expression", _token->get_data());
                             }
                         }
                     }
 
-                    shift_expression new_expr;
-                    new_expr.type = _token->get_token_type();
-                    new_expr.begin = this->m_tokenizer->get_index();
-                    new_expr.end = new_expr.begin + 1;
-                    new_expr.set_right();
+                    const token_type type = _token->get_token_type();
+                    const uint_fast8_t priority = operator_priority(type, (_token->is_strictly_prefix_overload_operator() && !_token->is_binary_operator()) || (_token->is_prefix_overload_operator() && expr->type == token::token_type::NULL_TOKEN));
 
-                    const uint_fast8_t priority = operator_priority(new_expr.type, (_token->is_strictly_prefix_overload_operator() && !_token->is_binary_operator()) || (_token->is_prefix_overload_operator() && expr->type == token::token_type::NULL_TOKEN));
+                    // find the innermost open operator the new one binds tighter than; prefix operators bind right to left
+                    size_t index = this->m_operators.size();
+                    for (; index > operators_begin; index--) {
+                        const shift_expression* const open = this->m_operators[index - 1];
+                        const bool is_prefix = (is_strictly_prefix_operator(open->type) && !is_binary_operator(open->type)) || (is_prefix_operator(open->type) && open->get_left()->type == token::token_type::NULL_TOKEN);
+                        const uint_fast8_t open_priority = operator_priority(open->type, is_prefix);
 
-                    shift_expression* const new_ret_expr = ret_expr.type == token_type::COMMA ? &ret_expr.sub.back() : &ret_expr;
+                        if (priority > open_priority || (is_prefix && priority == open_priority))
+                            break;
+                    }
 
-                    shift_expression* current_parent = expr->parent;
+                    shift_expression* const parent = index > operators_begin ? this->m_operators[index - 1] : nullptr;
+                    arena_list<shift_expression>& siblings = parent ? parent->sub : *top;
 
-                    for (; current_parent != nullptr; current_parent = current_parent->parent) {
-                        const bool is_prefix = (is_strictly_prefix_operator(current_parent->type) && !is_binary_operator(current_parent->type)) || (is_prefix_operator(current_parent->type) && current_parent->get_left()->type == token::token_type::NULL_TOKEN);
-                        const bool l_to_r = !is_prefix;
-                        const uint_fast8_t parent_priority = operator_priority(current_parent->type, is_prefix);
+                    arena_list<shift_expression> left;
+                    left.splice_back(siblings);
 
-                        if (priority > parent_priority || (!l_to_r && (priority == parent_priority))) {
-                            new_expr.set_left(std::move(*current_parent->get_right()));
-                            current_parent->set_right(std::move(new_expr));
-                            current_parent->get_right()->parent = current_parent;
-                            current_parent->get_right()->get_left()->parent = current_parent->get_right();
-                            current_parent->get_right()->get_right()->parent = current_parent->get_right();
-                            expr = current_parent->get_right()->get_right();
-                            break;
-                        }
-                    }
+                    shift_expression& new_expr = siblings.emplace_back(this->m_arena);
+                    new_expr.type = type;
+                    new_expr.begin = this->m_tokenizer->get_index();
+                    new_expr.end = new_expr.begin + 1;
+                    new_expr.parent = parent;
 
-                    if (current_parent == nullptr) {
-                        new_expr.set_left(std::move(*new_ret_expr));
-                        *new_ret_expr = std::move(new_expr);
-                        new_ret_expr->get_left()->parent = new_ret_expr;
-                        new_ret_expr->get_right()->parent = new_ret_expr;
-                        expr = new_ret_expr->get_right();
-                    }
+                    left.back().parent = &new_expr;
+                    new_expr.sub.splice_back(left);
+                    expr = &new_expr.sub.emplace_back(this->m_arena);
+                    expr->parent = &new_expr;
+
+                    this->m_operators.resize(index);
+                    this->m_operators.push_back(&new_expr);
                     continue;
                 }
 
@@ -1448,7 +1914,7 @@ namespace shift {
                         expr->begin = this->m_tokenizer->get_index();
                         expr->end = expr->begin + 1;
                         this->m_tokenizer->next_token(); // Skip 'new'
-                        expr->sub.push_back(m_parse_expression(end_type));
+                        expr->sub.push_back(this->m_arena, m_parse_expression(end_type));
                         const shift_expression& new_left = expr->sub.back();
 
                         if (!new_left.is_bracket() && !new_left.is_function_call() && !new_left.is_array()) {
@@ -1480,7 +1946,7 @@ namespace shift {
                         if (after_name.is_left_bracket()) {
                             expr->set_function_call();
                             this->m_tokenizer->next_token();
-                            expr->sub.push_back(m_parse_expression(token_type::RIGHT_BRACKET));
+                            expr->sub.push_back(this->m_arena, m_parse_expression(token_type::RIGHT_BRACKET));
 
                             const token& right_function_call_bracket = this->m_tokenizer->current_token();
                             if (!right_function_call_bracket.is_right_bracket()) {
@@ -1494,7 +1960,7 @@ namespace shift {
                             expr->set_array();
                             do {
                                 this->m_tokenizer->next_token();
-                                expr->sub.push_back(std::move(m_parse_expression(token_type::RIGHT_SQUARE_BRACKET)));
+                                expr->sub.push_back(this->m_arena, std::move(m_parse_expression(token_type::RIGHT_SQUARE_BRACKET)));
                                 if (expr->sub.back().type == token::token_type::COMMA) {
                                     this->m_token_error(*expr->sub.back().begin, "unexpected ',' inside array indexer inside expression");
                                 }
@@ -1511,28 +1977,29 @@ namespace shift {
                     continue;
                 }
 
-                this->m_token_error(*_token, "unexpected token '" + std::string(_token->get_data()) + "' in expression");
+                this->m_token_error(*_token, "unexpected token '%' in expression", _token->get_data());
             }
 
             if (expr->parent != nullptr) {
                 if (is_unary_operator(expr->parent->type)) {
                     if (expr->parent->get_left()->type != token_type::NULL_TOKEN && expr->parent->get_right()->type != token_type::NULL_TOKEN && !is_binary_operator(expr->parent->type)) {
-                        this->m_token_error(*expr->parent->begin, "unexpected operator '" + std::string(expr->parent->begin->get_data()) + "' inside expression");
+                        this->m_token_error(*expr->parent->begin, "unexpected operator '%' inside expression", expr->parent->begin->get_data());
                     } else if (expr->parent->get_left()->type == token_type::NULL_TOKEN && expr->parent->get_right()->type == token_type::NULL_TOKEN) {
-                        this->m_token_error(*expr->parent->begin, "unexpected operator '" + std::string(expr->parent->begin->get_data()) + "' inside expression");
+                        this->m_token_error(*expr->parent->begin, "unexpected operator '%' inside expression", expr->parent->begin->get_data());
                     }
                 }
 
                 if (is_binary_operator(expr->parent->type)) {
                     if (expr->parent->get_right()->size() == 0 && expr->parent->get_left()->size() != 0 && !is_suffix_operator(expr->parent->type)) {
-                        this->m_token_error(*expr->parent->begin, "unexpected operator '" + std::string(expr->parent->begin->get_data()) + "' inside expression");
+                        this->m_token_error(*expr->parent->begin, "unexpected operator '%' inside expression", expr->parent->begin->get_data());
                     }
                 }
             } else if (this->m_tokenizer->reverse_peek_token().is_comma()) {
                 this->m_token_error(this->m_tokenizer->reverse_peek_token(), "misplaced ',' inside expression");
             }
 
-            return ret_expr;
+            this->m_operators.resize(operators_begin);
+            return std::move(root.back());
         }
 
         const token& parser::m_skip_before(const std::string_view str) noexcept {
@@ -1548,51 +2015,30 @@ namespace shift {
             return this->m_tokenizer->reverse_token();
         }
 
-        void parser::m_token_error(const token& token_, const std::string_view msg) {
+        void parser::m_token_error(const token& token_, const char* const format, const std::string_view first, const std::string_view second) {
             if (!this->m_error_handler) return;
-            SHIFT_PARSER_ERROR_(token_, msg);
-            std::string line = std::string(this->m_get_line(token_));
-            size_t use_col = token_.get_file_index().col;
-            std::for_each(line.begin(), line.end(), [&use_col](char& ch) {
-                if (ch == '\t') {
-                    ch = ' ';
-                    use_col -= 3;
-                }
-                });
-
-            std::string indexer(use_col - 1, ' ');
-            indexer.append(token_.get_data().size(), '^');
-            SHIFT_PARSER_ERROR_LOG(line);
-            SHIFT_PARSER_ERROR_LOG(indexer);
+            const file_indexer index = token_.get_file_index();
+            this->m_error_handler->add_diagnostic(error_handler::message_type::error, this->m_get_source_file(), uint32_t(index.line), uint32_t(index.col),
+                uint32_t(token_.get_data().size()), format, first, second);
         }
 
-        void parser::m_token_error(const token& token_, const std::string& msg) { return m_token_error(token_, std::string_view(msg.c_str(), msg.length())); }
-        void parser::m_token_error(const token& token_, const char* const msg) { return m_token_error(token_, std::string_view(msg, std::strlen(msg))); }
-
-        void parser::m_token_warning(const token& token_, const std::string_view msg) {
+        void parser::m_token_warning(const token& token_, const char* const format, const std::string_view first, const std::string_view second) {
             if (!this->m_error_handler) return;
             if (!this->m_error_handler->is_print_warnings()) return;
-            SHIFT_PARSER_WARNING_(token_, msg);
-            std::string line = std::string(this->m_get_line(token_));
-            size_t use_col = token_.get_file_index().col;
-            std::for_each(line.begin(), line.end(), [&use_col](char& ch) {
-                if (ch == '\t') {
-                    ch = ' ';
-                    use_col -= 3;
-                }
-                });
-
-            std::string indexer(use_col - 1, ' ');
-            indexer.append(token_.get_data().size(), '^');
-
-            SHIFT_PARSER_WARNING_LOG(line);
-            SHIFT_PARSER_WARNING_LOG(indexer);
+            const file_indexer index = token_.get_file_index();
+            this->m_error_handler->add_diagnostic(error_handler::message_type::warning, this->m_get_source_file(), uint32_t(index.line), uint32_t(index.col),
+                uint32_t(token_.get_data().size()), format, first, second);
         }
 
-        void parser::m_token_warning(const token& token_, const std::string& msg) { return m_token_warning(token_, std::string_view(msg.c_str(), msg.length())); }
-        void parser::m_token_warning(const token& token_, const char* const msg) { return m_token_warning(token_, std::string_view(msg, std::strlen(msg))); }
-
-        std::string_view parser::m_get_line(const token& token_) const noexcept { return this->m_tokenizer->get_lines()[token_.get_file_index().line - 1]; }
+        const std::shared_ptr<const error_handler::source_file>& parser::m_get_source_file(void) {
+            // made once for all the diagnostics of the file, unless the tokenizer has since moved to another
+            if (!this->m_source_file || this->m_source_file->source.get() != this->m_tokenizer->get_source_map()
+                || this->m_source_file->path != this->m_tokenizer->get_file().get_path()) {
+                this->m_source_file = std::make_shared<const error_handler::source_file>(error_handler::source_file { this->m_tokenizer->get_file().get_path(),
+                    this->m_tokenizer->get_shared_source_map(), std::string() });
+            }
+            return this->m_source_file;
+        }
 
         bool parser::m_is_module_defined(void) const noexcept { return this->m_module.size() != 0; }
 
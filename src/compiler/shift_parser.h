@@ -1,6 +1,10 @@
 /**
  * @file compiler/shift_parser.h
  */
+#ifndef SHIFT_PARSER_H_
+#define SHIFT_PARSER_H_ 1
+
+#include "compiler/shift_arena.h"
 #include "compiler/shift_tokenizer.h"
 #include "compiler/shift_error_handler.h"
 
@@ -9,17 +13,73 @@
 #include <list>
 #include <vector>
 #include <utility>
+#include <variant>
 #include <algorithm>
 
 namespace shift {
     namespace compiler {
+        class module_file;
+        class flat_tree;
+
         class parser {
         public:
             inline parser(tokenizer* const tokenizer) noexcept;
             inline parser(error_handler* const error_handler, tokenizer* const tokenizer) noexcept;
 
+            /// Minimum number of tokens a file must hold for parse() to parse its classes on several threads
+            static constexpr size_t parallel_min_tokens = size_t(1) << 16;
+
+            /**
+             * Parses the file from the current token of the tokenizer.
+             *
+             * With more than one thread (see set_threads()), the top-level classes of a large file are parsed concurrently.
+             * The classes are first found by matching brackets, and the rest of the file is parsed on the calling thread,
+             * leaving each class to another thread along with the state the parser was in when it reached it. The trees of
+             * the classes are then spliced back in order, and their diagnostics put back where a serial parse would have
+             * reported them. A class that a serial parse would not have ended at its matching bracket, such as one whose
+             * error recovery runs into the next class, makes the whole file be parsed again serially, so the tree and the
+             * diagnostics are always the same as those of a serial parse. Every thread works on its own copy of the tokens.
+             *
+             * Parsing stops early, leaving the tree unfinished, once the error handler has reached its error limit (see
+             * error_handler::set_max_errors()).
+             */
             void parse();
 
+            /**
+             * Parses the bodies of the functions that parse() skipped (see set_lazy_bodies()), as if they had been parsed
+             * along with the rest of the file.
+             */
+            void parse_bodies();
+
+            /**
+             * Makes parse() skip function bodies, only matching their brackets, for passes that need nothing but the
+             * declarations of a file. A skipped body is parsed the first time its statements are asked for (see
+             * m_get_statements()), or by parse_bodies(); its diagnostics are only reported then.
+             */
+            inline void set_lazy_bodies(const bool lazy = true) noexcept { m_lazy_bodies = lazy; }
+            inline bool is_lazy_bodies() const noexcept { return m_lazy_bodies; }
+
+            /// Maximum number of threads used by parse(); 0 uses one per hardware thread, and 1 (the default) parses serially
+            inline void set_threads(const size_t threads) noexcept { m_threads = threads; }
+            inline size_t get_threads() const noexcept { return m_threads; }
+
+            /// Part of the syntax tree edit() parsed again
+            enum class reparse_scope: uint_fast8_t {
+                none, // the edit replaced no tokens
+                function, // the body of one function
+                class_, // the members of one class
+                file // the whole file
+            };
+
+            /**
+             * Edits the source of the file (see tokenizer::edit()), and parses again only the smallest part of the syntax
+             * tree holding every token the edit replaced: the body of a function, the members of a class, or else the
+             * whole file. The rest of the tree is kept, pointed at where its tokens are after the edit. Like the tokenizer,
+             * only what is parsed again is diagnosed again.
+             * @return The part of the tree that was parsed again.
+             */
+            reparse_scope edit(size_t offset, size_t removed, std::string_view inserted);
+
             inline tokenizer* get_tokenizer() const noexcept { return m_tokenizer; }
             inline void set_tokenizer(tokenizer* const tokenizer) noexcept { m_tokenizer = tokenizer; }
             inline error_handler* get_error_handler() noexcept { return m_error_handler; }
@@ -27,6 +87,15 @@ namespace shift {
             inline void set_error_handler(error_handler* const error_handler) noexcept { m_error_handler = error_handler; }
 
             static uint_fast8_t operator_priority(const token::token_type type, const bool prefix = false) noexcept;
+
+            /// Number of statements parsed
+            inline size_t get_statement_count() const noexcept { return m_statement_count; }
+
+            /// Number of bytes a statement takes in the syntax tree, not counting its expressions
+            static size_t get_statement_size() noexcept;
+
+            /// Number of bytes held by the syntax tree
+            inline size_t get_tree_size() const noexcept { return m_arena.capacity(); }
         public:
             enum mods: uint_fast8_t {
                 PUBLIC = 0x1,
@@ -48,10 +117,23 @@ namespace shift {
 
             using shift_module = shift_name;
 
+            // The syntax tree lives in the arena of its parser (see m_arena): its lists are arena lists, and its nodes are
+            // never destroyed, so they must stay trivially destructible.
+
             struct shift_name {
                 typename std::vector<token>::const_iterator begin, end;
 
                 inline auto size() const noexcept { return end - begin; }
+
+                /// Compares names by their interned symbols, rather than by their text
+                inline bool operator==(const shift_name& other) const noexcept {
+                    if (size() != other.size()) return false;
+                    for (auto a = begin, b = other.begin; a != end; a++, b++)
+                        if (a->get_token_type() != b->get_token_type() || a->get_symbol() != b->get_symbol()) return false;
+                    return true;
+                }
+
+                inline bool operator!=(const shift_name& other) const noexcept { return !(*this == other); }
             };
 
             struct shift_type {
@@ -63,7 +145,7 @@ namespace shift {
                 token::token_type type = token::token_type::NULL_TOKEN;
                 shift_expression* parent = nullptr;
                 typename std::vector<token>::const_iterator begin, end;
-                std::list<shift_expression> sub;
+                arena_list<shift_expression> sub;
 
                 inline auto size() const noexcept { return end - begin; }
 
@@ -84,33 +166,21 @@ namespace shift {
                 inline const shift_expression* get_left() const noexcept { return has_left() ? &sub.front() : nullptr; }
                 inline const shift_expression* get_right() const noexcept { return has_right() ? &sub.back() : nullptr; }
 
-                inline void set_left(const shift_expression& expr) {
-                    sub.resize(shift_clamp(sub.size(), 1, 2));
-                    sub.front() = expr;
-                    sub.front().parent = this;
-                }
-
-                inline void set_left(shift_expression&& expr) {
-                    sub.resize(shift_clamp(sub.size(), 1, 2));
+                inline void set_left(arena& arena, shift_expression&& expr) {
+                    sub.resize(arena, shift_clamp(sub.size(), 1u, 2u));
                     sub.front() = std::move(expr);
                     sub.front().parent = this;
                 }
 
-                inline void set_left() { set_left(shift_expression()); }
+                inline void set_left(arena& arena) { set_left(arena, shift_expression()); }
 
-                inline void set_right(const shift_expression& expr) {
-                    sub.resize(2);
-                    sub.back() = expr;
-                    sub.back().parent = this;
-                }
-
-                inline void set_right(shift_expression&& expr) {
-                    sub.resize(2);
+                inline void set_right(arena& arena, shift_expression&& expr) {
+                    sub.resize(arena, 2);
                     sub.back() = std::move(expr);
                     sub.back().parent = this;
                 }
 
-                inline void set_right() { set_right(shift_expression()); }
+                inline void set_right(arena& arena) { set_right(arena, shift_expression()); }
             };
 
             struct shift_variable {
@@ -134,181 +204,143 @@ namespace shift {
                     return_,
                     continue_,
                     break_
-                } type;
+                };
 
-                struct {
-                    shift_expression expr;
-                    shift_module module_;
-                    shift_variable variable;
-                    const token* token = nullptr;
-                } data[2];
+                struct expression_data { shift_expression expr; };
+                struct variable_data { shift_variable variable; };
+                struct block_data { const token* begin = nullptr, * end = nullptr; };
+                struct use_data { const token* token = nullptr; shift_module module_; };
+                struct keyword_data { const token* token = nullptr; shift_expression expr; }; // if, else, while and return
+                struct for_data { const token* token = nullptr; shift_expression condition, increment; };
+                struct jump_data { const token* token = nullptr; }; // continue and break
 
-                std::list<shift_statement> sub;
+                // Only the fields of the kind of the statement are stored; the alternative at index N is that of statement_type N,
+                // and get<N>() must only be used on statements of that kind
+                std::variant<std::monostate, expression_data, variable_data, block_data, use_data, keyword_data, keyword_data,
+                    keyword_data, for_data, keyword_data, jump_data, jump_data> data;
 
-                inline void set_if(const token* const token) noexcept {
-                    type = statement_type::if_;
-                    data[0].token = token;
-                }
+                arena_list<shift_statement> sub;
 
-                inline void set_if_condition(const shift_expression& expr) { data[0].expr = expr; }
+                inline statement_type get_type() const noexcept { return statement_type(data.index()); }
 
-                inline void set_if_condition(shift_expression&& expr) noexcept { data[0].expr = std::move(expr); }
+                template<statement_type type>
+                inline auto& get() noexcept { return *std::get_if<std::size_t(type)>(&data); }
 
-                inline const token* get_if() const noexcept { return data[0].token; }
+                template<statement_type type>
+                inline const auto& get() const noexcept { return *std::get_if<std::size_t(type)>(&data); }
 
-                inline const shift_expression& get_if_condition() const noexcept { return data[0].expr; }
+                template<statement_type type>
+                inline auto& set() noexcept { return data.template emplace<std::size_t(type)>(); }
 
-                inline std::list<shift_statement>& get_if_statements() noexcept { return sub; }
+                inline void set_if(const token* const token) noexcept { set<statement_type::if_>().token = token; }
 
-                inline const std::list<shift_statement>& get_if_statements() const noexcept { return sub; }
+                inline void set_if_condition(shift_expression&& expr) noexcept { get<statement_type::if_>().expr = std::move(expr); }
 
-                inline void set_else_condition(const shift_expression& expr) { data[0].expr = expr; }
+                inline const token* get_if() const noexcept { return get<statement_type::if_>().token; }
 
-                inline void set_else_condition(shift_expression&& expr) noexcept { data[0].expr = std::move(expr); }
+                inline const shift_expression& get_if_condition() const noexcept { return get<statement_type::if_>().expr; }
 
-                inline void set_else(const token* const token) noexcept {
-                    type = statement_type::else_;
-                    data[0].token = token;
-                }
+                inline arena_list<shift_statement>& get_if_statements() noexcept { return sub; }
 
-                inline const token* get_else() const noexcept { return data[0].token; }
+                inline const arena_list<shift_statement>& get_if_statements() const noexcept { return sub; }
 
-                inline const shift_expression& get_else_condition() const noexcept { return data[0].expr; }
+                inline void set_else_condition(shift_expression&& expr) noexcept { get<statement_type::else_>().expr = std::move(expr); }
 
-                inline std::list<shift_statement>& get_else_statements() noexcept { return sub; }
+                inline void set_else(const token* const token) noexcept { set<statement_type::else_>().token = token; }
 
-                inline const std::list<shift_statement>& get_else_statements() const noexcept { return sub; }
+                inline const token* get_else() const noexcept { return get<statement_type::else_>().token; }
 
-                inline void set_while(const token* const token) noexcept {
-                    type = statement_type::while_;
-                    data[0].token = token;
-                }
+                inline const shift_expression& get_else_condition() const noexcept { return get<statement_type::else_>().expr; }
 
-                inline void set_while_condition(const shift_expression& expr) { data[0].expr = expr; }
+                inline arena_list<shift_statement>& get_else_statements() noexcept { return sub; }
 
-                inline void set_while_condition(shift_expression&& expr) noexcept { data[0].expr = std::move(expr); }
+                inline const arena_list<shift_statement>& get_else_statements() const noexcept { return sub; }
 
-                inline const token* get_while() const noexcept { return data[0].token; }
+                inline void set_while(const token* const token) noexcept { set<statement_type::while_>().token = token; }
 
-                inline const shift_expression& get_while_condition() const noexcept { return data[0].expr; }
+                inline void set_while_condition(shift_expression&& expr) noexcept { get<statement_type::while_>().expr = std::move(expr); }
 
-                inline std::list<shift_statement>& get_while_statements() noexcept { return sub; }
+                inline const token* get_while() const noexcept { return get<statement_type::while_>().token; }
 
-                inline const std::list<shift_statement>& get_while_statements() const noexcept { return sub; }
+                inline const shift_expression& get_while_condition() const noexcept { return get<statement_type::while_>().expr; }
 
-                inline void set_for(const token* const token) noexcept {
-                    type = statement_type::for_;
-                    data[0].token = token;
-                }
+                inline arena_list<shift_statement>& get_while_statements() noexcept { return sub; }
 
-                inline const token* get_for() const noexcept { return data[0].token; }
+                inline const arena_list<shift_statement>& get_while_statements() const noexcept { return sub; }
 
-                inline void set_for_initializer(const shift_statement& statement) {
-                    sub.clear();
-                    sub.push_back(statement);
-                }
+                inline void set_for(const token* const token) noexcept { set<statement_type::for_>().token = token; }
+
+                inline const token* get_for() const noexcept { return get<statement_type::for_>().token; }
 
-                inline void set_for_initializer(shift_statement&& statement) {
+                inline void set_for_initializer(arena& arena, shift_statement&& statement) {
                     sub.clear();
-                    sub.push_back(std::move(statement));
+                    sub.push_back(arena, std::move(statement));
                 }
 
-                inline void set_for_condition(const shift_expression& expr) { data[0].expr = expr; }
+                inline void set_for_condition(shift_expression&& expr) noexcept { get<statement_type::for_>().condition = std::move(expr); }
 
-                inline void set_for_condition(shift_expression&& expr) noexcept { data[0].expr = std::move(expr); }
-
-                inline void set_for_increment(const shift_expression& expr) { data[1].expr = expr; }
-
-                inline void set_for_increment(shift_expression&& expr) noexcept { data[1].expr = std::move(expr); }
+                inline void set_for_increment(shift_expression&& expr) noexcept { get<statement_type::for_>().increment = std::move(expr); }
 
                 inline const shift_statement& get_for_initializer() const noexcept { return sub.front(); }
 
-                inline const shift_expression& get_for_condition() const noexcept { return data[0].expr; }
+                inline const shift_expression& get_for_condition() const noexcept { return get<statement_type::for_>().condition; }
 
-                inline const shift_expression& get_for_increment() const noexcept { return data[1].expr; }
+                inline const shift_expression& get_for_increment() const noexcept { return get<statement_type::for_>().increment; }
 
-                inline std::list<shift_statement>& get_for_statements() noexcept { return sub; }
+                inline arena_list<shift_statement>& get_for_statements() noexcept { return sub; }
 
-                inline const std::list<shift_statement>& get_for_statements() const noexcept { return sub; }
+                inline const arena_list<shift_statement>& get_for_statements() const noexcept { return sub; }
 
-                inline void set_return(const token* const token) noexcept {
-                    type = statement_type::return_;
-                    data[0].token = token;
-                }
+                inline void set_return(const token* const token) noexcept { set<statement_type::return_>().token = token; }
 
-                inline void set_return_statement(const shift_expression& expr) { data[0].expr = expr; }
-
-                inline void set_return_statement(shift_expression&& expr) noexcept { data[0].expr = std::move(expr); }
-
-                inline void set_return_expression(const shift_expression& expr) { return set_return_statement(expr); }
+                inline void set_return_statement(shift_expression&& expr) noexcept { get<statement_type::return_>().expr = std::move(expr); }
 
                 inline void set_return_expression(shift_expression&& expr) noexcept { return set_return_statement(std::move(expr)); }
 
-                inline const token* get_return() const noexcept { return data[0].token; }
-
-                inline const shift_expression& get_return_statement() const noexcept { return data[0].expr; }
-
-                inline void set_expression() noexcept { type = statement_type::expression; }
-
-                inline void set_expression(const shift_expression& expr) { data[0].expr = expr; }
+                inline const token* get_return() const noexcept { return get<statement_type::return_>().token; }
 
-                inline void set_expression(shift_expression&& expr) noexcept { data[0].expr = std::move(expr); }
+                inline const shift_expression& get_return_statement() const noexcept { return get<statement_type::return_>().expr; }
 
-                inline const shift_expression& get_expression() const noexcept { return data[0].expr; }
+                inline void set_expression() noexcept { set<statement_type::expression>(); }
 
-                inline void set_variable() noexcept { type = statement_type::variable_alloc; }
+                inline void set_expression(shift_expression&& expr) noexcept { get<statement_type::expression>().expr = std::move(expr); }
 
-                inline void set_variable(const shift_variable& var_) { data[0].variable = var_; }
+                inline const shift_expression& get_expression() const noexcept { return get<statement_type::expression>().expr; }
 
-                inline void set_variable(shift_variable&& var_) noexcept { data[0].variable = std::move(var_); }
+                inline void set_variable() noexcept { set<statement_type::variable_alloc>(); }
 
-                inline const shift_variable& get_variable() const noexcept { return data[0].variable; }
+                inline void set_variable(shift_variable&& var_) noexcept { get<statement_type::variable_alloc>().variable = std::move(var_); }
 
-                inline void set_block(const token* const token) noexcept {
-                    type = statement_type::scope_begin;
-                    data[0].token = token;
-                }
+                inline const shift_variable& get_variable() const noexcept { return get<statement_type::variable_alloc>().variable; }
 
-                inline void set_block(const std::list<shift_statement>& sub) noexcept { this->sub = sub; }
+                inline void set_block(const token* const token) noexcept { set<statement_type::scope_begin>().begin = token; }
 
-                inline void set_block(std::list<shift_statement>&& sub) noexcept { this->sub = std::move(sub); }
+                inline void set_block(arena_list<shift_statement>&& sub) noexcept { this->sub = std::move(sub); }
 
-                inline const token* get_block() const noexcept { return data[0].token; }
+                inline const token* get_block() const noexcept { return get<statement_type::scope_begin>().begin; }
 
-                inline const std::list<shift_statement>& get_block_statements() const noexcept { return sub; }
+                inline const arena_list<shift_statement>& get_block_statements() const noexcept { return sub; }
 
                 inline void set_block_end(const token* const token) noexcept {
-                    type = statement_type::scope_begin;
-                    data[1].token = token;
+                    if (get_type() != statement_type::scope_begin)
+                        set<statement_type::scope_begin>();
+                    get<statement_type::scope_begin>().end = token;
                 }
 
-                inline const token* get_block_end() const noexcept { return data[1].token; }
+                inline const token* get_block_end() const noexcept { return get<statement_type::scope_begin>().end; }
 
-                inline void set_continue(const token* const token) noexcept {
-                    type = statement_type::continue_;
-                    data[0].token = token;
-                }
+                inline void set_continue(const token* const token) noexcept { set<statement_type::continue_>().token = token; }
 
-                inline void set_break(const token* const token) noexcept {
-                    type = statement_type::break_;
-                    data[0].token = token;
-                }
+                inline void set_break(const token* const token) noexcept { set<statement_type::break_>().token = token; }
 
-                inline void set_use(const token* const token) noexcept {
-                    type = statement_type::use;
-                    data[0].token = token;
-                }
+                inline void set_use(const token* const token) noexcept { set<statement_type::use>().token = token; }
 
-                inline void set_use_module(const shift_module& module_) noexcept {
-                    data[0].module_ = module_;
-                }
+                inline void set_use_module(const shift_module& module_) noexcept { get<statement_type::use>().module_ = module_; }
 
-                inline void set_use_module(shift_module&& module_) noexcept {
-                    data[0].module_ = std::move(module_);
-                }
+                inline void set_use_module(shift_module&& module_) noexcept { get<statement_type::use>().module_ = std::move(module_); }
 
-                inline const token* get_use() const noexcept { return data[0].token; }
-                inline const shift_module& get_use_module() const noexcept { return data[0].module_; }
+                inline const token* get_use() const noexcept { return get<statement_type::use>().token; }
+                inline const shift_module& get_use_module() const noexcept { return get<statement_type::use>().module_; }
             };
 
             struct shift_function {
@@ -316,8 +348,11 @@ namespace shift {
                 const token* name = nullptr;
                 mods mods = parser::mods(0x0);
                 shift_type return_type;
-                std::list<std::pair<shift_type, const token*>> parameters;
-                std::list<shift_statement> statements;
+                arena_list<std::pair<shift_type, const token*>> parameters;
+                arena_list<shift_statement> statements; // empty until the body is parsed; see m_get_statements()
+                typename std::vector<token>::const_iterator body, body_end; // first token of the body, and the furthest one it was skipped or parsed to
+                bool lazy = false; // whether the body was skipped and is yet to be parsed
+                bool standalone = false; // whether the body was started with no specifiers pending, so that it parses the same on its own
             };
 
             struct shift_class {
@@ -325,34 +360,47 @@ namespace shift {
                 shift_class* parent = nullptr, * base = nullptr;
                 const token* name = nullptr;
                 mods mods = parser::mods(0x0);
-                typename std::list<shift_module>::const_iterator implicit_use_statements;
-                std::list<shift_module> use_statements;
-                std::list<shift_function> functions;
-                std::list<shift_variable> variables;
+                const shift_module* implicit_use_statements = nullptr; // the last global use statement before the class, if any
+                arena_list<shift_module> use_statements;
+                arena_list<shift_function> functions;
+                arena_list<shift_variable> variables;
+                typename std::vector<token>::const_iterator body, body_end; // first token of the members, and the one they ended at
+            };
+
+            /// A top-level class parse() may leave to another thread, see m_parse_parallel()
+            struct class_span {
+                size_t begin = 0, end = 0; // the 'class' token, and the '}' matching the first '{' after it
+                bool taken = false; // whether the file was parsed up to the class, which was left to another thread
+                bool parsed = false; // whether the class parsed the same as it would have serially, ending at its '}'
+                std::list<std::pair<mods, const token*>> mods; // the state of the parser when it reached the class
+                shift_module module_;
+                const shift_module* implicit_use_statements = nullptr;
+                size_t messages = 0; // number of diagnostics reported before the class
+                error_handler errors; // those of the class
             };
         private:
+            bool m_parse_file(std::vector<class_span>* spans);
+            bool m_parse_parallel(size_t threads);
             void m_parse_access_specifier(void);
             void m_parse_use(void);
-            void m_parse_use(std::list<shift_module>&);
+            void m_parse_use(arena_list<shift_module>&);
             void m_parse_module(void);
             void m_parse_class(void);
             void m_parse_class(shift_class&);
             void m_parse_function(shift_function&);
-            void m_parse_function_block(shift_function&, std::list<shift_statement>&, size_t count = -1);
+            void m_parse_function_block(shift_function&, arena_list<shift_statement>&, size_t count = -1);
+            arena_list<shift_statement>& m_get_statements(shift_function&);
+            bool m_reparse(shift_class&, shift_function*, size_t open, size_t close);
             shift_expression m_parse_expression(const token::token_type end_type = token::token_type::SEMICOLON);
 
             shift_name m_parse_name(const char* const);
             shift_type m_parse_type(const char* const);
 
-            void m_token_error(const token& token_, const std::string_view msg);
-            void m_token_error(const token& token_, const std::string& msg);
-            void m_token_error(const token& token_, const char* const msg);
-
-            void m_token_warning(const token& token_, const std::string_view msg);
-            void m_token_warning(const token& token_, const std::string& msg);
-            void m_token_warning(const token& token_, const char* const msg);
+            // Reports a diagnostic at token_, formatted from format once printed, with each '%' replaced by the next argument
+            void m_token_error(const token& token_, const char* const format, const std::string_view first = std::string_view(), const std::string_view second = std::string_view());
+            void m_token_warning(const token& token_, const char* const format, const std::string_view first = std::string_view(), const std::string_view second = std::string_view());
 
-            std::string_view m_get_line(const token&) const noexcept;
+            const std::shared_ptr<const error_handler::source_file>& m_get_source_file(void);
 
             const token& m_skip_until(const std::string_view) noexcept;
             const token& m_skip_until(const std::string&) noexcept;
@@ -370,20 +418,42 @@ namespace shift {
             const token& m_skip_before(const typename token::token_type) noexcept;
 
             const token& m_skip_until_closing(const typename token::token_type) noexcept;
+            bool m_match_closing(const typename token::token_type) noexcept;
 
             mods m_get_mods(void) const noexcept;
             void m_add_mod(mods, const token&) noexcept;
             void m_clear_mods(void) noexcept;
 
             bool m_is_module_defined(void) const noexcept;
+            inline bool m_is_error_limit_reached(void) const noexcept { return this->m_error_handler && this->m_error_handler->is_error_limit_reached(); }
+
+            // Call visit with a reference to every token iterator and token pointer of the syntax tree, always in the same order
+            template<typename F> void m_visit_tokens(F&& visit);
+            template<typename F> void m_visit_tokens(shift_name&, F&);
+            template<typename F> void m_visit_tokens(shift_type&, F&);
+            template<typename F> void m_visit_tokens(shift_expression&, F&);
+            template<typename F> void m_visit_tokens(shift_variable&, F&);
+            template<typename F> void m_visit_tokens(arena_list<shift_statement>&, F&);
+            template<typename F> void m_visit_tokens(shift_function&, F&);
+            template<typename F> void m_visit_tokens(shift_class&, F&);
+        private:
+            friend class module_file; // serializes the declarations of the syntax tree
+            friend class flat_tree; // lays out function bodies for the passes that walk them
         private:
             tokenizer* m_tokenizer;
             error_handler* m_error_handler;
 
+            arena m_arena; // holds the whole syntax tree, which is freed with it at once
             std::list<std::pair<mods, const token*>> m_mods;
             shift_module m_module;
-            std::list<shift_module> m_global_uses;
-            std::list<shift_class> m_classes;
+            arena_list<shift_module> m_global_uses;
+            arena_list<shift_class> m_classes;
+            std::vector<shift_expression*> m_operators; // open operators of the expressions being parsed, see m_parse_expression()
+            std::vector<size_t> m_token_indices; // where the tokens of the tree were before an edit, see edit()
+            std::shared_ptr<const error_handler::source_file> m_source_file; // shared by the diagnostics of the file
+            size_t m_statement_count = 0;
+            size_t m_threads = 1;
+            bool m_lazy_bodies = false;
         };
 
         inline parser::parser(tokenizer* const tokenizer) noexcept: m_tokenizer(tokenizer), m_error_handler(tokenizer->get_error_handler()) {}
@@ -397,4 +467,6 @@ constexpr inline shift::compiler::parser::mods operator|(const shift::compiler::
 constexpr inline shift::compiler::parser::mods& operator|=(shift::compiler::parser::mods& f, const shift::compiler::parser::mods other) noexcept { return f = operator|(f, other); }
 constexpr inline shift::compiler::parser::mods operator&(const shift::compiler::parser::mods f, const shift::compiler::parser::mods other) noexcept { return shift::compiler::parser::mods(std::underlying_type_t<shift::compiler::parser::mods>(f) & std::underlying_type_t<shift::compiler::parser::mods>(other)); }
 constexpr inline shift::compiler::parser::mods& operator&=(shift::compiler::parser::mods& f, const shift::compiler::parser::mods other) noexcept { return f = operator&(f, other); }
-constexpr inline shift::compiler::parser::mods operator~(const shift::compiler::parser::mods f) noexcept { return shift::compiler::parser::mods(~std::underlying_type_t<shift::compiler::parser::mods>(f)); }
\ No newline at end of file
+constexpr inline shift::compiler::parser::mods operator~(const shift::compiler::parser::mods f) noexcept { return shift::compiler::parser::mods(~std::underlying_type_t<shift::compiler::parser::mods>(f)); }
+
+#endif /* SHIFT_PARSER_H_ */
\ No newline at end of file
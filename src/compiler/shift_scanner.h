@@ -0,0 +1,233 @@
+/**
+ * @file compiler/shift_scanner.h
+ *
+ * Block scanning kernels used by the tokenizer to skip over runs of characters
+ */
+#ifndef SHIFT_SCANNER_H_
+#define SHIFT_SCANNER_H_ 1
+
+#include "shift_config.h"
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+// Pick the widest vector extension the compiler is allowed to emit; anything else uses the scalar kernels
+#if defined(__AVX2__)
+#	define SHIFT_SCANNER_AVX2 1
+#	include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define SHIFT_SCANNER_SSE2 1
+#	include <emmintrin.h>
+#else
+#	define SHIFT_SCANNER_SCALAR 1
+#endif
+
+#if defined(_MSC_VER) && !defined(SHIFT_SCANNER_SCALAR)
+#	include <intrin.h>
+#endif
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/**
+		 * Kernels that skip whole runs of characters at a time.
+		 *
+		 * None of the kernels bounds-check their reads: the input must be followed by at least
+		 * filesystem::mapped_file::padding zero bytes (one vector width is enough). Runs of blanks and
+		 * identifier characters end at the first zero byte, while the searches take an explicit end.
+		 */
+		namespace scanner {
+			/// Character classes, as stored within scanner::char_classes
+			enum char_class: std::uint8_t {
+				BLANK = (1 << 0), // ' ', \t, \v, \r, \f
+				NEWLINE = (1 << 1), // \n
+				IDENTIFIER_START = (1 << 2), // [a-zA-Z_]
+				IDENTIFIER = (1 << 3), // [a-zA-Z0-9_]
+				DIGIT = (1 << 4), // [0-9]
+			};
+
+			constexpr inline std::array<std::uint8_t, 256> make_char_classes(void) noexcept {
+				std::array<std::uint8_t, 256> classes {};
+
+				for (unsigned ch = 'a'; ch <= 'z'; ch++) classes[ch] |= IDENTIFIER_START | IDENTIFIER;
+				for (unsigned ch = 'A'; ch <= 'Z'; ch++) classes[ch] |= IDENTIFIER_START | IDENTIFIER;
+				for (unsigned ch = '0'; ch <= '9'; ch++) classes[ch] |= IDENTIFIER | DIGIT;
+				classes['_'] |= IDENTIFIER_START | IDENTIFIER;
+
+				classes[' '] |= BLANK;
+				classes['\t'] |= BLANK;
+				classes['\v'] |= BLANK;
+				classes['\r'] |= BLANK;
+				classes['\f'] |= BLANK;
+				classes['\n'] |= NEWLINE;
+				return classes;
+			}
+
+			/// ASCII-only (and thus locale-independent) character classification table
+			inline constexpr std::array<std::uint8_t, 256> char_classes = make_char_classes();
+
+			constexpr inline bool is(const char ch, const std::uint8_t char_class) noexcept { return (char_classes[static_cast<unsigned char>(ch)] & char_class) != 0; }
+			constexpr inline bool is_blank(const char ch) noexcept { return is(ch, BLANK); }
+			constexpr inline bool is_identifier_start(const char ch) noexcept { return is(ch, IDENTIFIER_START); }
+			constexpr inline bool is_identifier(const char ch) noexcept { return is(ch, IDENTIFIER); }
+			constexpr inline bool is_digit(const char ch) noexcept { return is(ch, DIGIT); }
+
+#ifndef SHIFT_SCANNER_SCALAR
+			namespace detail {
+				inline unsigned count_trailing_zeros(const std::uint32_t mask) noexcept {
+#	ifdef _MSC_VER
+					unsigned long index;
+					_BitScanForward(&index, mask);
+					return static_cast<unsigned>(index);
+#	else
+					return static_cast<unsigned>(__builtin_ctz(mask));
+#	endif
+				}
+
+				inline unsigned popcount(const std::uint32_t mask) noexcept { return static_cast<unsigned>(std::bitset<32>(mask).count()); }
+
+				/// Thin wrapper over the vector instructions, so that every kernel is written once
+				struct block {
+#	ifdef SHIFT_SCANNER_AVX2
+					static constexpr std::size_t width = 32;
+					__m256i data;
+
+					static inline block load(const char* const ptr) noexcept { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)) }; }
+					inline std::uint32_t eq(const char ch) const noexcept { return std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, _mm256_set1_epi8(ch)))); }
+
+					// Signed compares; bytes >= 0x80 are negative and therefore never inside an ASCII range
+					inline std::uint32_t in_range(const char min, const char max) const noexcept {
+						return std::uint32_t(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpgt_epi8(data, _mm256_set1_epi8(char(min - 1))),
+							_mm256_cmpgt_epi8(_mm256_set1_epi8(char(max + 1)), data))));
+					}
+
+					inline std::uint32_t lower_in_range(const char min, const char max) const noexcept {
+						const __m256i lower = _mm256_or_si256(data, _mm256_set1_epi8(0x20));
+						return std::uint32_t(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8(char(min - 1))),
+							_mm256_cmpgt_epi8(_mm256_set1_epi8(char(max + 1)), lower))));
+					}
+#	else
+					static constexpr std::size_t width = 16;
+					__m128i data;
+
+					static inline block load(const char* const ptr) noexcept { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)) }; }
+					inline std::uint32_t eq(const char ch) const noexcept { return std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(data, _mm_set1_epi8(ch)))); }
+
+					// Signed compares; bytes >= 0x80 are negative and therefore never inside an ASCII range
+					inline std::uint32_t in_range(const char min, const char max) const noexcept {
+						return std::uint32_t(_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(data, _mm_set1_epi8(char(min - 1))),
+							_mm_cmpgt_epi8(_mm_set1_epi8(char(max + 1)), data))));
+					}
+
+					inline std::uint32_t lower_in_range(const char min, const char max) const noexcept {
+						const __m128i lower = _mm_or_si128(data, _mm_set1_epi8(0x20));
+						return std::uint32_t(_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8(char(min - 1))),
+							_mm_cmpgt_epi8(_mm_set1_epi8(char(max + 1)), lower))));
+					}
+#	endif
+					/// Mask with one bit set for every byte of the block
+					static constexpr std::uint32_t full = width == 32 ? ~std::uint32_t(0) : ((std::uint32_t(1) << width) - 1);
+				};
+
+				/// Mask of the bytes below @a count
+				inline std::uint32_t below(const std::size_t count) noexcept { return count >= 32 ? ~std::uint32_t(0) : ((std::uint32_t(1) << count) - 1); }
+			}
+#endif
+
+			/**
+			 * Skips a run of blanks (whitespace other than \n).
+			 * @param[in] ptr Start of the run.
+			 * @param[out] tabs Incremented by the number of tabs within the run.
+			 * @return Pointer to the first character that is not a blank.
+			 */
+			inline const char* skip_blanks(const char* ptr, std::size_t& tabs) noexcept {
+#ifdef SHIFT_SCANNER_SCALAR
+				for (; is_blank(*ptr); ++ptr)
+					tabs += *ptr == '\t';
+				return ptr;
+#else
+				for (;; ptr += detail::block::width) {
+					const detail::block block = detail::block::load(ptr);
+					const std::uint32_t tab_mask = block.eq('\t');
+					const std::uint32_t stop = ~(block.eq(' ') | tab_mask | block.in_range('\v', '\r')) & detail::block::full;
+
+					if (stop) {
+						const unsigned count = detail::count_trailing_zeros(stop);
+						tabs += detail::popcount(tab_mask & detail::below(count));
+						return ptr + count;
+					}
+					tabs += detail::popcount(tab_mask);
+				}
+#endif
+			}
+
+			/**
+			 * Skips the remaining characters of an identifier.
+			 * @param[in] ptr Any character within the identifier.
+			 * @return Pointer to the first character that is not [a-zA-Z0-9_].
+			 */
+			inline const char* skip_identifier(const char* ptr) noexcept {
+#ifdef SHIFT_SCANNER_SCALAR
+				for (; is_identifier(*ptr); ++ptr);
+				return ptr;
+#else
+				for (;; ptr += detail::block::width) {
+					const detail::block block = detail::block::load(ptr);
+					const std::uint32_t stop = ~(block.lower_in_range('a', 'z') | block.in_range('0', '9') | block.eq('_')) & detail::block::full;
+
+					if (stop)
+						return ptr + detail::count_trailing_zeros(stop);
+				}
+#endif
+			}
+
+			/**
+			 * Searches for the first occurrence of any of the template characters.
+			 * @param[in] ptr Where to start searching.
+			 * @param[in] end End of the data.
+			 * @return Pointer to the first matching character, or @a end if there are none.
+			 */
+			template<char... Chars>
+			inline const char* find_first_of(const char* ptr, const char* const end) noexcept {
+#ifdef SHIFT_SCANNER_SCALAR
+				for (; ptr < end && !((*ptr == Chars) || ...); ++ptr);
+				return ptr;
+#else
+				for (; ptr < end; ptr += detail::block::width) {
+					const detail::block block = detail::block::load(ptr);
+					const std::uint32_t found = (block.eq(Chars) | ...);
+
+					if (found) {
+						ptr += detail::count_trailing_zeros(found);
+						return ptr < end ? ptr : end;
+					}
+				}
+				return end;
+#endif
+			}
+
+			/**
+			 * Counts the occurrences of a character.
+			 * @param[in] ptr Start of the data.
+			 * @param[in] end End of the data.
+			 * @param[in] ch The character to count.
+			 */
+			inline std::size_t count(const char* ptr, const char* const end, const char ch) noexcept {
+				std::size_t count = 0;
+#ifdef SHIFT_SCANNER_SCALAR
+				for (; ptr < end; ++ptr)
+					count += *ptr == ch;
+#else
+				for (; ptr < end; ptr += detail::block::width)
+					count += detail::popcount(detail::block::load(ptr).eq(ch) & detail::below(static_cast<std::size_t>(end - ptr)));
+#endif
+				return count;
+			}
+		}
+	}
+}
+
+#endif /* SHIFT_SCANNER_H_ */
@@ -0,0 +1,215 @@
+/**
+ * @file compiler/shift_source_map.cpp
+ */
+
+#include "compiler/shift_source_map.h"
+#include "compiler/shift_scanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		namespace {
+			/// Every live source map, sorted by the address of its source
+			struct source_registry {
+				std::shared_mutex mutex;
+				std::vector<const source_map*> maps;
+				std::atomic<std::size_t> generation { 0 }; // bumped on every change, invalidates the per-thread caches
+			};
+
+			source_registry& registry(void) noexcept {
+				static source_registry registry;
+				return registry;
+			}
+
+			struct registry_cache {
+				const source_map* map = nullptr;
+				std::size_t generation = std::size_t(-1);
+			};
+
+			thread_local registry_cache cache;
+		}
+
+		source_map::source_map(std::shared_ptr<const filesystem::mapped_file> file): m_file(std::move(file)) {
+			if (!this->m_file)
+				return;
+
+			this->m_source = this->m_file->view();
+
+			const char* const begin = this->m_source.data();
+			const char* const end = begin + this->m_source.size();
+
+			this->m_line_starts.reserve(scanner::count(begin, end, '\n') + 1);
+			this->m_line_starts.push_back(0);
+			for (const char* newline = scanner::find_first_of<'\n'>(begin, end); newline != end; newline = scanner::find_first_of<'\n'>(newline + 1, end))
+				this->m_line_starts.push_back(static_cast<std::uint32_t>(newline + 1 - begin));
+
+			source_registry& registry = compiler::registry();
+			std::unique_lock<std::shared_mutex> lock(registry.mutex);
+			registry.maps.insert(std::upper_bound(registry.maps.begin(), registry.maps.end(), this, [](const source_map* const a, const source_map* const b) {
+				return a->data() < b->data();
+				}), this);
+			registry.generation++;
+		}
+
+		source_map::~source_map() noexcept {
+			if (!this->m_file && !this->m_buffer)
+				return;
+
+			source_registry& registry = compiler::registry();
+			std::unique_lock<std::shared_mutex> lock(registry.mutex);
+			registry.maps.erase(std::remove(registry.maps.begin(), registry.maps.end(), this), registry.maps.end());
+			registry.generation++;
+		}
+
+		bool source_map::edit(const std::size_t offset, std::size_t removed, const std::string_view inserted) {
+			if (offset > this->m_source.size())
+				return false;
+
+			removed = std::min(removed, this->m_source.size() - offset);
+			const std::size_t size = this->m_source.size() - removed + inserted.size();
+			if (size > std::numeric_limits<std::uint32_t>::max())
+				return false;
+
+			std::unique_ptr<char[]> buffer(new char[size + filesystem::mapped_file::padding]);
+			std::memcpy(buffer.get(), this->m_source.data(), offset);
+			std::memcpy(buffer.get() + offset, inserted.data(), inserted.size());
+			std::memcpy(buffer.get() + offset + inserted.size(), this->m_source.data() + offset + removed, this->m_source.size() - offset - removed);
+			std::memset(buffer.get() + size, 0, filesystem::mapped_file::padding);
+
+			{ // lines starting within (offset, offset + removed] lost their line break, the later ones move
+				const auto first = std::upper_bound(this->m_line_starts.begin(), this->m_line_starts.end(), std::uint32_t(offset));
+				const auto last = std::upper_bound(first, this->m_line_starts.end(), std::uint32_t(offset + removed));
+				const auto next = this->m_line_starts.erase(first, last);
+
+				for (auto it = next; it != this->m_line_starts.end(); ++it)
+					*it = static_cast<std::uint32_t>(*it - removed + inserted.size());
+
+				std::vector<std::uint32_t> starts;
+				for (std::size_t i = 0; i < inserted.size(); i++) {
+					if (inserted[i] == '\n')
+						starts.push_back(static_cast<std::uint32_t>(offset + i + 1));
+				}
+				this->m_line_starts.insert(next, starts.cbegin(), starts.cend());
+			}
+
+			// the source moves, so it has to be registered again
+			source_registry& registry = compiler::registry();
+			std::unique_lock<std::shared_mutex> lock(registry.mutex);
+			if (this->m_file || this->m_buffer)
+				registry.maps.erase(std::remove(registry.maps.begin(), registry.maps.end(), this), registry.maps.end());
+
+			this->m_buffer = std::move(buffer);
+			this->m_source = std::string_view(this->m_buffer.get(), size);
+			this->m_file.reset();
+
+			registry.maps.insert(std::upper_bound(registry.maps.begin(), registry.maps.end(), this, [](const source_map* const a, const source_map* const b) {
+				return a->data() < b->data();
+				}), this);
+			registry.generation++;
+			return true;
+		}
+
+		std::string_view source_map::line(const std::size_t line) const noexcept {
+			if (line == 0 || line > this->m_line_starts.size())
+				return std::string_view();
+
+			const std::size_t begin = this->m_line_starts[line - 1];
+			std::size_t end = line < this->m_line_starts.size() ? this->m_line_starts[line] - 1 : this->m_source.size();
+
+			// drop \r of \r\n
+			if (end > begin && this->m_source[end - 1] == '\r')
+				end--;
+
+			return this->m_source.substr(begin, end - begin);
+		}
+
+		std::size_t source_map::line_of(const std::size_t offset) const noexcept {
+			if (this->m_line_starts.empty() || offset > this->m_source.size())
+				return 0;
+
+			return std::size_t(std::upper_bound(this->m_line_starts.cbegin(), this->m_line_starts.cend(), std::uint32_t(offset)) - this->m_line_starts.cbegin());
+		}
+
+		std::size_t source_map::offset(const file_indexer index) const noexcept {
+			const std::string_view line = this->line(index.line);
+			if (line.data() == nullptr)
+				return npos;
+
+			std::size_t col = 1;
+			for (const char& ch : line) {
+				if (col == index.col)
+					return std::size_t(&ch - this->m_source.data());
+				if (col > index.col)
+					return npos;
+				col += ch == '\t' ? 4 : 1; // tabs are 4 spaces
+			}
+
+			return npos;
+		}
+
+		file_indexer source_map::position(const std::size_t offset) const noexcept {
+			const std::size_t line = this->line_of(offset);
+			if (line == 0)
+				return file_indexer();
+
+			const char* const line_begin = this->m_source.data() + this->m_line_starts[line - 1];
+			const char* const ptr = this->m_source.data() + offset;
+
+			// tabs are 4 spaces
+			return { line, std::size_t(ptr - line_begin) + 1 + scanner::count(line_begin, ptr, '\t') * 3 };
+		}
+
+		std::size_t source_map::token_index(const std::size_t offset) const noexcept {
+			if (offset == npos)
+				return npos;
+
+			const auto it = std::lower_bound(this->m_token_offsets.cbegin(), this->m_token_offsets.cend(), std::uint32_t(offset));
+			return it != this->m_token_offsets.cend() && *it == offset ? std::size_t(it - this->m_token_offsets.cbegin()) : npos;
+		}
+
+		std::size_t source_map::token_index_at(const std::size_t offset) const noexcept {
+			if (offset == npos || this->m_token_offsets.empty())
+				return npos;
+
+			// the last token starting at or before offset, unless offset lies before the first token
+			const auto it = std::upper_bound(this->m_token_offsets.cbegin(), this->m_token_offsets.cend(), std::uint32_t(offset));
+			return it == this->m_token_offsets.cbegin() ? 0 : std::size_t(it - this->m_token_offsets.cbegin()) - 1;
+		}
+
+		const source_map* source_map::find(const char* const ptr) noexcept {
+			if (!ptr)
+				return nullptr;
+
+			source_registry& registry = compiler::registry();
+
+			const std::size_t generation = registry.generation.load(std::memory_order_acquire);
+			if (cache.generation == generation && cache.map && cache.map->contains(ptr))
+				return cache.map;
+
+			std::shared_lock<std::shared_mutex> lock(registry.mutex);
+			const auto it = std::upper_bound(registry.maps.cbegin(), registry.maps.cend(), ptr, [](const char* const ptr, const source_map* const map) {
+				return ptr < map->data();
+				});
+
+			if (it == registry.maps.cbegin() || !(*(it - 1))->contains(ptr))
+				return nullptr;
+
+			cache.map = *(it - 1);
+			cache.generation = registry.generation.load(std::memory_order_relaxed);
+			return cache.map;
+		}
+
+		file_indexer source_map::locate(const char* const ptr) noexcept {
+			const source_map* const map = source_map::find(ptr);
+			return map ? map->position(ptr) : file_indexer();
+		}
+	}
+}
@@ -0,0 +1,171 @@
+/**
+ * @file compiler/shift_source_map.h
+ *
+ * Maps positions within a source file to line/column pairs and back
+ */
+#ifndef SHIFT_SOURCE_MAP_H_
+#define SHIFT_SOURCE_MAP_H_ 1
+
+#include "shift_config.h"
+#include "filesystem/mapped_file.h"
+#include "compiler/shift_literal_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+
+		struct file_indexer {
+			size_t line = 0, col = 0;
+
+			constexpr inline bool operator==(const file_indexer other) const noexcept { return this->col == other.col && this->line == other.line; }
+
+			constexpr inline bool operator!=(const file_indexer& other) const noexcept { return !this->operator==(other); }
+
+			constexpr inline bool operator>(const file_indexer other) const noexcept { return this->line == other.line ? this->col > other.col : this->line > other.line; }
+
+			constexpr inline bool operator<(const file_indexer other) const noexcept { return this->line == other.line ? this->col < other.col : this->line < other.line; }
+
+			constexpr inline bool operator>=(const file_indexer& other) const noexcept { return !this->operator<(other); }
+
+			constexpr inline bool operator<=(const file_indexer& other) const noexcept { return !this->operator>(other); }
+
+		};
+
+		/**
+		 * Position index over the contents of a source file.
+		 *
+		 * Maps byte offsets, line/column pairs and token indices to one another, through binary searches over the
+		 * offsets of every line start and of every token start.
+		 *
+		 * Tokens only store a pointer into their source, so every live source map is registered globally by the address
+		 * range of its source; source_map::find() recovers the map (and thus the line/column) of any token on demand.
+		 * Columns count tabs as 4 characters, the same way the tokenizer does.
+		 *
+		 * The source can be edited in place (see edit()), after which it lives in a buffer of its own rather than in the
+		 * mapping of its file.
+		 */
+		class source_map {
+		public:
+			/// Returned by the lookups that find nothing
+			static constexpr std::size_t npos = std::size_t(-1);
+		public:
+			explicit source_map(std::shared_ptr<const filesystem::mapped_file> file);
+			source_map(const source_map&) = delete;
+			source_map(source_map&&) = delete;
+			~source_map() noexcept;
+
+			source_map& operator=(const source_map&) = delete;
+			source_map& operator=(source_map&&) = delete;
+
+			inline const char* data(void) const noexcept { return this->m_source.data(); }
+			inline std::size_t size(void) const noexcept { return this->m_source.size(); }
+			inline std::string_view source(void) const noexcept { return this->m_source; }
+
+			/// Whether @a ptr points into (or one past the end of) this source
+			inline bool contains(const char* const ptr) const noexcept { return ptr >= this->m_source.data() && ptr <= this->m_source.data() + this->m_source.size(); }
+
+			inline std::size_t line_count(void) const noexcept { return this->m_line_starts.size(); }
+
+			/**
+			 * Retrieves a line of the source, without its line terminator.
+			 * @param[in] line The line number (starting at 1).
+			 */
+			std::string_view line(std::size_t line) const noexcept;
+
+			/**
+			 * Retrieves the line that contains a byte offset.
+			 * @return The line number (starting at 1), or 0 if @a offset is past the end of the source.
+			 */
+			std::size_t line_of(std::size_t offset) const noexcept;
+
+			/// Byte offset of a pointer into the source
+			inline std::size_t offset(const char* const ptr) const noexcept { return this->contains(ptr) ? std::size_t(ptr - this->m_source.data()) : npos; }
+
+			/**
+			 * Inverse of position().
+			 * @return Byte offset of the character at @a index, or npos if there is no such character.
+			 */
+			std::size_t offset(file_indexer index) const noexcept;
+
+			/**
+			 * Computes the line and column of a position within this source.
+			 * @param[in] offset A byte offset within the source.
+			 * @return The position of @a offset (starting at 1:1), or 0:0 if it is past the end of the source.
+			 */
+			file_indexer position(std::size_t offset) const noexcept;
+
+			/// Same as position(offset(ptr)); 0:0 if @a ptr does not belong to this source
+			inline file_indexer position(const char* const ptr) const noexcept { return this->contains(ptr) ? this->position(std::size_t(ptr - this->m_source.data())) : file_indexer(); }
+
+			/// Pointer to the character at @a index, or nullptr if there is no such character
+			inline const char* pointer(const file_indexer index) const noexcept {
+				const std::size_t offset = this->offset(index);
+				return offset == npos ? nullptr : this->m_source.data() + offset;
+			}
+
+			/**
+			 * Replaces a range of the source, and updates the line table to match.
+			 *
+			 * The source moves to a new buffer, so every pointer into it is invalidated; token offsets and literals are
+			 * left for the tokenizer to update.
+			 * @param[in] offset The byte offset of the range, at most size().
+			 * @param[in] removed The length of the range, clamped to the end of the source.
+			 * @param[in] inserted What the range is replaced with.
+			 * @return False (and nothing is changed) if the edited source would be too large.
+			 */
+			bool edit(std::size_t offset, std::size_t removed, std::string_view inserted);
+
+			/**
+			 * Records the start offset of every token of the source, which must be in ascending order.
+			 */
+			inline void set_token_offsets(std::vector<std::uint32_t>&& offsets) noexcept { this->m_token_offsets = std::move(offsets); }
+
+			inline const std::vector<std::uint32_t>& token_offsets(void) const noexcept { return this->m_token_offsets; }
+
+			inline std::size_t token_count(void) const noexcept { return this->m_token_offsets.size(); }
+
+			/**
+			 * Finds the token that starts at a byte offset.
+			 * @return The index of the token, or npos if no token starts at @a offset.
+			 */
+			std::size_t token_index(std::size_t offset) const noexcept;
+
+			/**
+			 * Finds the token closest to a byte offset, e.g. the token under a cursor.
+			 * @return The index of the last token that starts at or before @a offset (the first token if there is none),
+			 * or npos if there are no tokens.
+			 */
+			std::size_t token_index_at(std::size_t offset) const noexcept;
+
+			/// Decoded values of the literal tokens of the source, keyed by token offset
+			inline literal_table& literals(void) noexcept { return this->m_literals; }
+			inline const literal_table& literals(void) const noexcept { return this->m_literals; }
+
+			/**
+			 * Finds the source map that owns a pointer.
+			 * @param[in] ptr A pointer into any source that is currently mapped.
+			 * @return The owning source map, or nullptr if there is none.
+			 */
+			static const source_map* find(const char* ptr) noexcept;
+
+			/// Convenience for source_map::find(ptr)->position(ptr); 0:0 when no map owns @a ptr
+			static file_indexer locate(const char* ptr) noexcept;
+		private:
+			std::shared_ptr<const filesystem::mapped_file> m_file;
+			std::unique_ptr<char[]> m_buffer; // the edited source, followed by filesystem::mapped_file::padding zero bytes
+			std::string_view m_source;
+			std::vector<std::uint32_t> m_line_starts; // byte offset of the first character of every line
+			std::vector<std::uint32_t> m_token_offsets; // byte offset of the first character of every token
+			literal_table m_literals;
+		};
+	}
+}
+
+#endif /* SHIFT_SOURCE_MAP_H_ */
@@ -0,0 +1,106 @@
+/**
+ * @file compiler/shift_symbols.cpp
+ */
+
+#include "compiler/shift_symbols.h"
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		namespace {
+			constexpr std::size_t shard_count = 64;
+
+			struct symbol_shard {
+				std::shared_mutex mutex;
+				std::unordered_map<std::string_view, symbol_id> ids; // keys point into symbol_registry::names
+			};
+
+			struct symbol_registry {
+				std::array<symbol_shard, shard_count> shards;
+				std::shared_mutex names_mutex;
+				std::deque<std::string> names; // indexed by ID; never reallocates its elements, so views into it stay valid
+
+				symbol_registry(void) {
+					// the keywords take the IDs of their keyword_type
+					this->names.resize(keywords::KW_COUNT);
+					for (const keywords::keyword_entry& entry : keywords::list)
+						this->names[entry.type] = std::string(entry.name);
+
+					for (symbol_id id = 0; id < keywords::KW_COUNT; id++)
+						this->shard_of(this->names[id]).ids.emplace(this->names[id], id);
+				}
+
+				inline symbol_shard& shard_of(const std::string_view name) noexcept { return this->shards[std::hash<std::string_view>()(name) % shard_count]; }
+			};
+
+			symbol_registry& registry(void) {
+				static symbol_registry registry;
+				return registry;
+			}
+
+			/// Names this thread has already interned, looked up without locking
+			thread_local std::unordered_map<std::string_view, symbol_id> cache;
+		}
+
+		symbol_id symbols::intern(const std::string_view name) {
+			// keywords are the most common names, and need no lookup at all
+			const keywords::keyword_type keyword = keywords::classify(name);
+			if (keyword != keywords::KW_NONE)
+				return keyword;
+
+			const auto cached = cache.find(name);
+			if (cached != cache.cend())
+				return cached->second;
+
+			symbol_registry& registry = compiler::registry();
+			symbol_shard& shard = registry.shard_of(name);
+
+			std::pair<std::string_view, symbol_id> symbol;
+			{
+				std::shared_lock<std::shared_mutex> lock(shard.mutex);
+				const auto it = shard.ids.find(name);
+				if (it != shard.ids.cend())
+					symbol = *it;
+			}
+
+			if (symbol.first.data() == nullptr) {
+				std::unique_lock<std::shared_mutex> lock(shard.mutex);
+				const auto it = shard.ids.find(name); // another thread may have interned it in the meantime
+				if (it != shard.ids.cend()) {
+					symbol = *it;
+				} else {
+					{
+						std::unique_lock<std::shared_mutex> names_lock(registry.names_mutex);
+						symbol.second = static_cast<symbol_id>(registry.names.size());
+						symbol.first = registry.names.emplace_back(name);
+					}
+					shard.ids.emplace(symbol);
+				}
+			}
+
+			cache.emplace(symbol);
+			return symbol.second;
+		}
+
+		std::string_view symbols::name(const symbol_id id) noexcept {
+			symbol_registry& registry = compiler::registry();
+			std::shared_lock<std::shared_mutex> lock(registry.names_mutex);
+			return id < registry.names.size() ? std::string_view(registry.names[id]) : std::string_view();
+		}
+
+		std::size_t symbols::count(void) noexcept {
+			symbol_registry& registry = compiler::registry();
+			std::shared_lock<std::shared_mutex> lock(registry.names_mutex);
+			return registry.names.size();
+		}
+	}
+}
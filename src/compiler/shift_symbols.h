@@ -0,0 +1,56 @@
+/**
+ * @file compiler/shift_symbols.h
+ *
+ * Process-wide interning of identifiers into dense integer IDs
+ */
+#ifndef SHIFT_SYMBOLS_H_
+#define SHIFT_SYMBOLS_H_ 1
+
+#include "shift_config.h"
+#include "compiler/shift_keywords.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/// ID of an interned name; the same name has the same ID in every file and on every thread
+		using symbol_id = std::uint32_t;
+
+		/**
+		 * Identifier interner shared by every tokenizer of the process.
+		 *
+		 * Names are handed out dense IDs in the order they are first seen, except for the keywords, which are interned up
+		 * front: the ID of a keyword is its keywords::keyword_type. The table is split into shards, each behind its own
+		 * lock, and every thread caches the names it has already looked up, so that tokenizers running in parallel rarely
+		 * contend. Interned names are never freed.
+		 */
+		namespace symbols {
+			/// ID of the empty name, never given to an identifier
+			inline constexpr symbol_id none = 0;
+
+			/**
+			 * Interns a name.
+			 * @return The ID of @a name.
+			 */
+			symbol_id intern(std::string_view name);
+
+			/**
+			 * Retrieves an interned name.
+			 * @return The name with the ID @a id, or an empty view if there is no such ID.
+			 */
+			std::string_view name(symbol_id id) noexcept;
+
+			/// Number of interned names, i.e. one past the highest ID
+			std::size_t count(void) noexcept;
+
+			/// Keyword with the ID @a id, or KW_NONE if @a id is not a keyword
+			constexpr inline keywords::keyword_type keyword(const symbol_id id) noexcept { return id < keywords::KW_COUNT ? keywords::keyword_type(id) : keywords::KW_NONE; }
+		}
+	}
+}
+
+#endif /* SHIFT_SYMBOLS_H_ */
@@ -0,0 +1,142 @@
+/**
+ * @file compiler/shift_thread_pool.cpp
+ */
+
+#include "compiler/shift_thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		thread_pool::thread_pool(std::size_t threads) {
+			if (!threads)
+				threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+			this->m_slots = std::make_unique<slot[]>(threads);
+			this->m_workers.reserve(threads - 1);
+			for (std::size_t self = 1; self < threads; self++)
+				this->m_workers.emplace_back(&thread_pool::m_worker, this, self);
+		}
+
+		thread_pool::~thread_pool() noexcept {
+			{
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				this->m_stop = true;
+			}
+			this->m_start.notify_all();
+
+			for (std::thread& worker : this->m_workers)
+				worker.join();
+		}
+
+		void thread_pool::m_run(const std::size_t count, void (*const task)(void*, std::size_t), void* const context) {
+			if (!count)
+				return;
+
+			// a single task, or a single thread, is not worth waking the workers for
+			const bool parallel = count > 1 && !this->m_workers.empty();
+			const std::size_t threads = parallel ? this->get_threads() : 1;
+
+			{
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				this->m_task = task;
+				this->m_context = context;
+				this->m_exception = nullptr;
+
+				for (std::size_t self = 0; self < this->get_threads(); self++) {
+					slot& own = this->m_slots[self];
+					std::lock_guard<std::mutex> slot_lock(own.mutex);
+					own.begin = self < threads ? count * self / threads : count;
+					own.end = self < threads ? count * (self + 1) / threads : count;
+				}
+
+				if (parallel) {
+					this->m_busy = this->m_workers.size();
+					this->m_generation++;
+				}
+			}
+
+			if (parallel)
+				this->m_start.notify_all();
+
+			this->m_work(0);
+
+			std::unique_lock<std::mutex> lock(this->m_mutex);
+			this->m_done.wait(lock, [this] { return this->m_busy == 0; });
+
+			this->m_task = nullptr;
+			this->m_context = nullptr;
+			if (const std::exception_ptr exception = std::exchange(this->m_exception, nullptr))
+				std::rethrow_exception(exception);
+		}
+
+		void thread_pool::m_worker(const std::size_t self) {
+			for (std::size_t generation = 0;;) {
+				{
+					std::unique_lock<std::mutex> lock(this->m_mutex);
+					this->m_start.wait(lock, [&] { return this->m_stop || this->m_generation != generation; });
+					if (this->m_stop)
+						return;
+					generation = this->m_generation;
+				}
+
+				this->m_work(self);
+
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				if (--this->m_busy == 0)
+					this->m_done.notify_one();
+			}
+		}
+
+		void thread_pool::m_work(const std::size_t self) {
+			for (std::size_t index; this->m_next(self, index);) {
+				try {
+					this->m_task(this->m_context, index);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(this->m_mutex);
+					if (!this->m_exception)
+						this->m_exception = std::current_exception();
+				}
+			}
+		}
+
+		bool thread_pool::m_next(const std::size_t self, std::size_t& index) {
+			slot& own = this->m_slots[self];
+			{
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (own.begin < own.end) {
+					index = own.begin++;
+					return true;
+				}
+			}
+
+			const std::size_t threads = this->get_threads();
+			for (std::size_t offset = 1; offset < threads; offset++) {
+				slot& victim = this->m_slots[(self + offset) % threads];
+				std::size_t begin, end;
+				{
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (victim.begin >= victim.end)
+						continue;
+
+					// the victim keeps the front half, which it is about to run anyway
+					begin = victim.begin + (victim.end - victim.begin) / 2;
+					end = victim.end;
+					victim.end = begin;
+				}
+
+				index = begin;
+				if (begin + 1 < end) {
+					std::lock_guard<std::mutex> lock(own.mutex);
+					own.begin = begin + 1;
+					own.end = end;
+				}
+				return true;
+			}
+			return false;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+/**
+ * @file compiler/shift_thread_pool.h
+ *
+ * Work-stealing pool of threads, used to compile source files concurrently
+ */
+#ifndef SHIFT_THREAD_POOL_H_
+#define SHIFT_THREAD_POOL_H_ 1
+
+#include "shift_config.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/**
+		 * Fixed set of threads running the tasks of one parallel loop at a time.
+		 *
+		 * Every thread owns a range of the indices of the loop and runs them front to back. A thread that runs out of
+		 * indices steals the back half of the range of another thread, so that a few slow tasks (such as one very large
+		 * source file) do not hold up the rest of the loop. The thread calling run() takes part in the loop as well.
+		 */
+		class thread_pool {
+		public:
+			/// Creates a pool of @a threads threads, counting the one calling run(); 0 uses one per hardware thread
+			explicit thread_pool(std::size_t threads = 0);
+			thread_pool(const thread_pool&) = delete;
+			thread_pool(thread_pool&&) = delete;
+			~thread_pool() noexcept;
+
+			thread_pool& operator=(const thread_pool&) = delete;
+			thread_pool& operator=(thread_pool&&) = delete;
+
+			/**
+			 * Calls @a task once for every index in [0, count), and returns once every call has returned.
+			 *
+			 * The calls may run in any order and on any thread of the pool. If some of them throw, the first exception
+			 * is rethrown once the loop is over. Tasks must not call run() themselves.
+			 */
+			template<typename F>
+			inline void run(const std::size_t count, F&& task) {
+				using function = std::remove_reference_t<F>;
+				this->m_run(count, [](void* const context, const std::size_t index) { (*static_cast<function*>(context))(index); }, const_cast<void*>(static_cast<const void*>(&task)));
+			}
+
+			/// Number of threads running the tasks, counting the one calling run()
+			inline std::size_t get_threads(void) const noexcept { return this->m_workers.size() + 1; }
+		private:
+			/// Indices of the loop left to one thread
+			struct alignas(64) slot {
+				std::mutex mutex;
+				std::size_t begin = 0, end = 0;
+			};
+		private:
+			void m_run(std::size_t count, void (*task)(void*, std::size_t), void* context);
+			void m_worker(std::size_t self);
+			void m_work(std::size_t self);
+			bool m_next(std::size_t self, std::size_t& index);
+		private:
+			std::vector<std::thread> m_workers;
+			std::unique_ptr<slot[]> m_slots; // one per thread; the thread calling run() owns the first
+
+			std::mutex m_mutex;
+			std::condition_variable m_start, m_done;
+			std::size_t m_generation = 0; // bumped by every loop, so that the workers can tell a new loop from a spurious wakeup
+			std::size_t m_busy = 0; // workers that have not yet run out of indices of the current loop
+			bool m_stop = false;
+
+			void (*m_task)(void*, std::size_t) = nullptr;
+			void* m_context = nullptr;
+			std::exception_ptr m_exception;
+		};
+	}
+}
+
+#endif /* SHIFT_THREAD_POOL_H_ */
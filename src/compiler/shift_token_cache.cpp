@@ -0,0 +1,358 @@
+/**
+ * @file compiler/shift_token_cache.cpp
+ */
+
+#include "compiler/shift_token_cache.h"
+#include "filesystem/file.h"
+#include "filesystem/mapped_file.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		namespace {
+			/**
+			 * Layout of a cache entry, all in native byte order:
+			 *
+			 *   header
+			 *   symbol_count  x { u32 offset, u32 length }            first occurrence of every distinct identifier
+			 *   token_count   x { u32 offset, u32 length, u16 type }  length is the index of the symbol for identifiers
+			 *   literal_count x { u32 offset, u8 kind, u8 valid, u64 value }
+			 *   string_count  x { u32 length, char[length] }           string pool of the literal table, in order
+			 *   message_count x { u32 type, u32 length, char[length] }
+			 */
+			struct entry_header {
+				char magic[8] = { 'S', 'H', 'I', 'F', 'T', 'T', 'O', 'K' };
+				std::uint32_t version = 2; // bump whenever the layout or the lexer output changes
+				std::uint32_t byte_order = 0x01020304;
+				std::uint64_t key = 0;
+				std::uint64_t source_size = 0;
+				std::uint32_t symbol_count = 0, token_count = 0, literal_count = 0, string_count = 0, message_count = 0;
+				std::uint32_t reserved = 0; // no padding, so that equal entries are equal byte for byte
+			};
+
+			constexpr entry_header expected_header;
+
+			class entry_writer {
+			public:
+				template<typename T>
+				inline void put(const T value) {
+					static_assert(std::is_trivially_copyable_v<T>);
+					this->data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+				}
+
+				inline void put(const std::string_view str) {
+					this->put(static_cast<std::uint32_t>(str.size()));
+					this->data.append(str.data(), str.size());
+				}
+			public:
+				std::string data;
+			};
+
+			class entry_reader {
+			public:
+				inline explicit entry_reader(const std::string_view data) noexcept: m_data(data) {}
+
+				template<typename T>
+				inline T get(void) noexcept {
+					static_assert(std::is_trivially_copyable_v<T>);
+					T value {};
+					if (this->m_take(sizeof(T)))
+						std::memcpy(&value, this->m_data.data() + this->m_index - sizeof(T), sizeof(T));
+					return value;
+				}
+
+				inline std::string_view get_string(void) noexcept {
+					const std::uint32_t length = this->get<std::uint32_t>();
+					return this->m_take(length) ? this->m_data.substr(this->m_index - length, length) : std::string_view();
+				}
+
+				/// Whether every read so far was within bounds
+				inline bool good(void) const noexcept { return this->m_good; }
+				inline bool at_end(void) const noexcept { return this->m_index == this->m_data.size(); }
+			private:
+				inline bool m_take(const std::size_t size) noexcept {
+					if (!this->m_good || size > this->m_data.size() - this->m_index)
+						return this->m_good = false;
+					this->m_index += size;
+					return true;
+				}
+			private:
+				std::string_view m_data;
+				std::size_t m_index = 0;
+				bool m_good = true;
+			};
+
+			// xxHash64, see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+			constexpr std::uint64_t prime64_1 = 0x9E3779B185EBCA87ull;
+			constexpr std::uint64_t prime64_2 = 0xC2B2AE3D27D4EB4Full;
+			constexpr std::uint64_t prime64_3 = 0x165667B19E3779F9ull;
+			constexpr std::uint64_t prime64_4 = 0x85EBCA77C2B2AE63ull;
+			constexpr std::uint64_t prime64_5 = 0x27D4EB2F165667C5ull;
+
+			constexpr inline std::uint64_t rotl64(const std::uint64_t value, const int count) noexcept { return (value << count) | (value >> (64 - count)); }
+
+			inline std::uint64_t read64(const char* const ptr) noexcept {
+				std::uint64_t value;
+				std::memcpy(&value, ptr, sizeof(value));
+				return value;
+			}
+
+			inline std::uint32_t read32(const char* const ptr) noexcept {
+				std::uint32_t value;
+				std::memcpy(&value, ptr, sizeof(value));
+				return value;
+			}
+
+			constexpr inline std::uint64_t xxh64_round(std::uint64_t acc, const std::uint64_t input) noexcept {
+				acc += input * prime64_2;
+				return rotl64(acc, 31) * prime64_1;
+			}
+
+			constexpr inline std::uint64_t xxh64_merge(const std::uint64_t acc, const std::uint64_t value) noexcept {
+				return (acc ^ xxh64_round(0, value)) * prime64_1 + prime64_4;
+			}
+
+			std::uint64_t xxh64(const std::string_view data, const std::uint64_t seed) noexcept {
+				const char* ptr = data.data();
+				const char* const end = ptr + data.size();
+				std::uint64_t hash;
+
+				if (data.size() >= 32) {
+					std::uint64_t v1 = seed + prime64_1 + prime64_2, v2 = seed + prime64_2, v3 = seed, v4 = seed - prime64_1;
+					for (; end - ptr >= 32; ptr += 32) {
+						v1 = xxh64_round(v1, read64(ptr));
+						v2 = xxh64_round(v2, read64(ptr + 8));
+						v3 = xxh64_round(v3, read64(ptr + 16));
+						v4 = xxh64_round(v4, read64(ptr + 24));
+					}
+
+					hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+					hash = xxh64_merge(hash, v1);
+					hash = xxh64_merge(hash, v2);
+					hash = xxh64_merge(hash, v3);
+					hash = xxh64_merge(hash, v4);
+				} else {
+					hash = seed + prime64_5;
+				}
+
+				hash += data.size();
+
+				for (; end - ptr >= 8; ptr += 8)
+					hash = rotl64(hash ^ xxh64_round(0, read64(ptr)), 27) * prime64_1 + prime64_4;
+
+				if (end - ptr >= 4) {
+					hash = rotl64(hash ^ (read32(ptr) * prime64_1), 23) * prime64_2 + prime64_3;
+					ptr += 4;
+				}
+
+				for (; ptr != end; ptr++)
+					hash = rotl64(hash ^ (static_cast<unsigned char>(*ptr) * prime64_5), 11) * prime64_1;
+
+				hash ^= hash >> 33;
+				hash *= prime64_2;
+				hash ^= hash >> 29;
+				hash *= prime64_3;
+				hash ^= hash >> 32;
+				return hash;
+			}
+		}
+
+		std::uint64_t token_cache::key(const std::string_view source, const std::string_view name) noexcept {
+			return xxh64(source, xxh64(name, 0));
+		}
+
+		bool token_cache::load(const std::uint64_t key, source_map& source, std::vector<token>& tokens, error_handler* const handler) const {
+			filesystem::mapped_file entry;
+			if (!entry.open(filesystem::file(this->m_path(key))))
+				return false;
+
+			entry_reader in(entry.view());
+			const entry_header header = in.get<entry_header>();
+			if (!in.good() || std::memcmp(header.magic, expected_header.magic, sizeof(header.magic)) != 0 || header.version != expected_header.version
+				|| header.byte_order != expected_header.byte_order || header.key != key || header.source_size != source.size())
+				return false;
+
+			// smallest size of every record, so that a damaged header can not make us reserve anything absurd
+			const std::uint64_t minimum_size = sizeof(header) + std::uint64_t(header.symbol_count) * 8 + std::uint64_t(header.token_count) * 10
+				+ std::uint64_t(header.literal_count) * 14 + std::uint64_t(header.string_count) * 4 + std::uint64_t(header.message_count) * 8;
+			if (minimum_size > entry.size())
+				return false;
+
+			const std::string_view text = source.source();
+			const auto in_source = [&text](const std::uint32_t offset, const std::uint32_t length) {
+				return offset <= text.size() && length <= text.size() - offset;
+			};
+
+			std::vector<std::pair<symbol_id, std::uint32_t>> symbols; // ID and length of every name
+			symbols.reserve(header.symbol_count);
+			for (std::uint32_t i = 0; i < header.symbol_count && in.good(); i++) {
+				const std::uint32_t offset = in.get<std::uint32_t>(), length = in.get<std::uint32_t>();
+				if (!in_source(offset, length))
+					return false;
+				symbols.emplace_back(symbols::intern(text.substr(offset, length)), length);
+			}
+
+			std::vector<token> loaded;
+			loaded.reserve(header.token_count);
+			for (std::uint32_t i = 0; i < header.token_count && in.good(); i++) {
+				const std::uint32_t offset = in.get<std::uint32_t>(), length = in.get<std::uint32_t>();
+				const token::token_type type = token::token_type(in.get<std::uint16_t>());
+
+				if (type == token::token_type::IDENTIFIER) {
+					if (length >= symbols.size() || !in_source(offset, symbols[length].second))
+						return false;
+					loaded.push_back(token(text.substr(offset, symbols[length].second), symbols[length].first));
+				} else {
+					if (!in_source(offset, length))
+						return false;
+					loaded.push_back(token(text.substr(offset, length), type));
+				}
+			}
+
+			literal_table literals;
+			literals.reserve(header.literal_count);
+			for (std::uint32_t i = 0; i < header.literal_count && in.good(); i++) {
+				const std::uint32_t offset = in.get<std::uint32_t>();
+
+				literal value;
+				value.kind = literal::literal_kind(in.get<std::uint8_t>());
+				value.valid = in.get<std::uint8_t>() != 0;
+				value.integer = in.get<std::uint64_t>(); // the whole union
+				literals.insert(offset, value);
+			}
+
+			for (std::uint32_t i = 0; i < header.string_count && in.good(); i++)
+				literals.intern(in.get_string());
+
+			error_handler messages;
+			for (std::uint32_t i = 0; i < header.message_count && in.good(); i++) {
+				const error_handler::message_type type = error_handler::message_type(in.get<std::uint32_t>());
+				messages.add_message(error_handler::message(std::string(in.get_string()), type));
+			}
+
+			if (!in.good() || !in.at_end() || literals.string_count() != header.string_count)
+				return false;
+
+			tokens = std::move(loaded);
+			source.literals() = std::move(literals);
+			token_cache::replay(messages, handler);
+			return true;
+		}
+
+		void token_cache::store(const std::uint64_t key, const source_map& source, const std::vector<token>& tokens, const error_handler& messages) const {
+			const char* const data = source.data();
+
+			// every identifier refers to the first occurrence of its name, which is interned again on load
+			std::unordered_map<symbol_id, std::uint32_t> locals;
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> names;
+			for (const token& token : tokens) {
+				if (token.is_identifier() && locals.emplace(token.get_symbol(), static_cast<std::uint32_t>(names.size())).second)
+					names.emplace_back(static_cast<std::uint32_t>(token.get_data().data() - data), static_cast<std::uint32_t>(token.get_data().size()));
+			}
+
+			const literal_table& literals = source.literals();
+
+			entry_header header;
+			header.key = key;
+			header.source_size = source.size();
+			header.symbol_count = static_cast<std::uint32_t>(names.size());
+			header.token_count = static_cast<std::uint32_t>(tokens.size());
+			header.literal_count = static_cast<std::uint32_t>(literals.size());
+			header.string_count = static_cast<std::uint32_t>(literals.string_count());
+			header.message_count = static_cast<std::uint32_t>(messages.get_messages().size());
+
+			entry_writer out;
+			out.data.reserve(sizeof(header) + names.size() * 8 + tokens.size() * 10 + literals.size() * 14);
+			out.put(header);
+
+			for (const auto& [offset, length] : names) {
+				out.put(offset);
+				out.put(length);
+			}
+
+			for (const token& token : tokens) {
+				out.put(static_cast<std::uint32_t>(token.get_data().data() - data));
+				out.put(token.is_identifier() ? locals[token.get_symbol()] : static_cast<std::uint32_t>(token.get_data().size()));
+				out.put(static_cast<std::uint16_t>(token.get_token_type()));
+			}
+
+			for (std::size_t i = 0; i < literals.size(); i++) {
+				out.put(literals.offset(i));
+				out.put(static_cast<std::uint8_t>(literals[i].kind));
+				out.put(static_cast<std::uint8_t>(literals[i].valid));
+				out.put(literals[i].integer);
+			}
+
+			for (std::uint32_t i = 0; i < header.string_count; i++)
+				out.put(literals.string(i));
+
+			for (const error_handler::message& message : messages.get_messages()) {
+				out.put(static_cast<std::uint32_t>(message.type));
+				out.put(std::string_view(message.get_text()));
+			}
+
+			std::error_code error;
+			std::filesystem::create_directories(this->m_directory, error);
+			if (error)
+				return;
+
+			// write under a name of our own, then move it in place in one step
+			const std::string path = this->m_path(key);
+			const std::string temporary = path + '.' + std::to_string(std::random_device()()) + ".tmp";
+			{
+				std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+				if (file)
+					file.write(out.data.data(), std::streamsize(out.data.size()));
+
+				if (!file) {
+					file.close();
+					std::filesystem::remove(temporary, error);
+					return;
+				}
+			}
+
+			std::filesystem::rename(temporary, path, error);
+			if (error)
+				std::filesystem::remove(temporary, error);
+		}
+
+		void token_cache::replay(const error_handler& messages, error_handler* const handler) {
+			if (!handler)
+				return;
+
+			for (const error_handler::message& message : messages.get_messages()) {
+				switch (message.type) {
+					case error_handler::message_type::error:
+						handler->add_error(message.get_text());
+						break;
+					case error_handler::message_type::warning:
+						handler->add_warning(message.get_text());
+						break;
+					default:
+						handler->add_message(error_handler::message(message.get_text(), message.type));
+						break;
+				}
+			}
+		}
+
+		std::string token_cache::m_path(const std::uint64_t key) const {
+			constexpr char digits[] = "0123456789abcdef";
+
+			std::string name(16, '0');
+			for (std::size_t i = 0; i < name.size(); i++)
+				name[name.size() - 1 - i] = digits[(key >> (i * 4)) & 0xF];
+
+			return (std::filesystem::path(this->m_directory) / name).string();
+		}
+	}
+}
@@ -0,0 +1,81 @@
+/**
+ * @file compiler/shift_token_cache.h
+ *
+ * On-disk cache of the tokens of source files, so that unchanged files need not be lexed again
+ */
+#ifndef SHIFT_TOKEN_CACHE_H_
+#define SHIFT_TOKEN_CACHE_H_ 1
+
+#include "shift_config.h"
+#include "compiler/shift_error_handler.h"
+#include "compiler/shift_source_map.h"
+#include "compiler/shift_tokenizer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/**
+		 * Directory of lexed source files, one cache file per distinct source.
+		 *
+		 * An entry is named after a 64-bit xxHash of the contents of its source, seeded with the name the diagnostics of
+		 * the source are reported under, and holds the tokens, the decoded literal table and the lexer diagnostics of the
+		 * source. Entries are mapped on load; since tokens point into their source, they only hold offsets, and identifiers
+		 * are interned again once per distinct name. Diagnostics are replayed through the error handler of the tokenizer,
+		 * so the output is the same whether or not the file was lexed.
+		 *
+		 * Entries are written to a temporary file first and then renamed, so that compilers sharing a cache directory
+		 * never see a partial entry. Anything unreadable is treated as a miss.
+		 */
+		class token_cache {
+		public:
+			/// Where the cache is kept, relative to the working directory
+			static constexpr std::string_view default_directory = ".shift-cache/tok";
+		public:
+			inline explicit token_cache(const std::string_view directory = default_directory): m_directory(directory) {}
+
+			/**
+			 * Computes the key of a source.
+			 * @param[in] source The contents of the source.
+			 * @param[in] name The name of the source as it appears in its diagnostics.
+			 */
+			static std::uint64_t key(std::string_view source, std::string_view name) noexcept;
+
+			/**
+			 * Loads the tokens of a source from the cache.
+			 * @param[in] key The key of the source, see key().
+			 * @param[in,out] source The source; its literal table is filled from the cache.
+			 * @param[out] tokens Receives the tokens of the source.
+			 * @param[out] handler Receives the diagnostics of the source, may be nullptr.
+			 * @return True on a hit, false if the source is not cached (in which case nothing was modified).
+			 */
+			bool load(std::uint64_t key, source_map& source, std::vector<token>& tokens, error_handler* handler) const;
+
+			/**
+			 * Stores the tokens of a source in the cache; failures are silently ignored.
+			 * @param[in] key The key of the source, see key().
+			 * @param[in] source The source, with its literal table.
+			 * @param[in] tokens The tokens of the source.
+			 * @param[in] messages The diagnostics of the source, recorded with warnings enabled and not treated as errors.
+			 */
+			void store(std::uint64_t key, const source_map& source, const std::vector<token>& tokens, const error_handler& messages) const;
+
+			/// Adds recorded diagnostics to @a handler, the way its own flags would have filtered them when reported
+			static void replay(const error_handler& messages, error_handler* handler);
+
+			inline const std::string& get_directory(void) const noexcept { return this->m_directory; }
+		private:
+			std::string m_path(std::uint64_t key) const;
+		private:
+			std::string m_directory;
+		};
+	}
+}
+
+#endif /* SHIFT_TOKEN_CACHE_H_ */
@@ -0,0 +1,99 @@
+/**
+ * @file compiler/shift_token_stream.cpp
+ */
+
+#include "compiler/shift_token_stream.h"
+
+#include <algorithm>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		token_stream::token_stream(error_handler* const handler, const filesystem::file& file, const size_t capacity, const size_t history)
+			: m_tokenizer(handler, file), m_history(history) {
+			size_t size = 16;
+			while (size < capacity || size <= history)
+				size <<= 1;
+			this->m_ring.resize(size);
+		}
+
+		bool token_stream::open(void) {
+			this->m_begin = this->m_end = this->m_index = 0;
+			this->m_marks.clear();
+			return this->m_tokenizer.open();
+		}
+
+		void token_stream::rollback(void) noexcept {
+			if (this->m_marks.empty()) return;
+
+			this->m_index = this->m_marks.back();
+			this->m_marks.pop_back();
+		}
+
+		void token_stream::pop_marks(size_t count) noexcept {
+			count = std::min(count, this->m_marks.size());
+			this->m_marks.resize(this->m_marks.size() - count);
+		}
+
+		const token& token_stream::current_token(void) { return this->m_fill(this->m_index) ? this->m_at(this->m_index) : token::null; }
+
+		const token& token_stream::next_token(size_t count) {
+			// like tokenizer::next_token(), the index may stop one past the last token
+			for (; count > 0 && this->m_fill(this->m_index); count--, this->m_index++);
+			return this->current_token();
+		}
+
+		const token& token_stream::reverse_token(size_t count) {
+			count = std::min(count, this->m_index - this->m_begin);
+			this->m_index -= count;
+			return this->current_token();
+		}
+
+		const token& token_stream::peek_token(const size_t count) {
+			// never peek past the end of the file
+			size_t index = this->m_index;
+			for (size_t i = 0; i < count && this->m_fill(index); i++, index++);
+			return this->m_fill(index) ? this->m_at(index) : token::null;
+		}
+
+		const token& token_stream::reverse_peek_token(const size_t count) {
+			if (count > this->m_index - this->m_begin) return token::null; // either before the file, or no longer buffered
+			return this->m_at(this->m_index - count);
+		}
+
+		bool token_stream::m_fill(const size_t index) {
+			while (index >= this->m_end) {
+				if (this->m_tokenizer.is_lexed())
+					return false;
+
+				this->m_trim();
+				if (this->m_end - this->m_begin == this->m_ring.size())
+					this->m_grow();
+
+				this->m_scratch.clear();
+				this->m_tokenizer.lex(this->m_scratch, this->m_ring.size() - (this->m_end - this->m_begin));
+
+				for (const token& token : this->m_scratch)
+					this->m_ring[this->m_end++ & (this->m_ring.size() - 1)] = token;
+			}
+
+			return true;
+		}
+
+		void token_stream::m_trim(void) noexcept {
+			size_t keep = this->m_index > this->m_history ? this->m_index - this->m_history : 0;
+			for (const size_t mark : this->m_marks)
+				keep = std::min(keep, mark);
+
+			this->m_begin = std::max(this->m_begin, std::min(keep, this->m_end));
+		}
+
+		void token_stream::m_grow(void) {
+			std::vector<token> ring(this->m_ring.size() * 2);
+			for (size_t index = this->m_begin; index < this->m_end; index++)
+				ring[index & (ring.size() - 1)] = this->m_at(index);
+			this->m_ring = std::move(ring);
+		}
+	}
+}
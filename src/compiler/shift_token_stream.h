@@ -0,0 +1,91 @@
+/**
+ * @file compiler/shift_token_stream.h
+ *
+ * Pull-based tokenizer, lexing tokens on demand into a bounded buffer
+ */
+#ifndef SHIFT_TOKEN_STREAM_H_
+#define SHIFT_TOKEN_STREAM_H_ 1
+
+#include "shift_config.h"
+#include "compiler/shift_tokenizer.h"
+
+#include <cstddef>
+#include <vector>
+
+/** Namespace shift */
+namespace shift {
+	/** Namespace compiler */
+	namespace compiler {
+		/**
+		 * Streaming alternative to tokenizer::tokenize().
+		 *
+		 * Instead of lexing the whole file up front, tokens are lexed as they are requested into a ring buffer.
+		 * Whenever the buffer makes room, it keeps the @a history tokens before the current one (for reverse_token() and
+		 * reverse_peek_token()), every token after the oldest active mark (for rollback()), and whatever lookahead has
+		 * been peeked at; it only grows when those do not fit. Memory therefore stays bounded by the lookahead and
+		 * backtracking depth of the consumer, rather than by the size of the file.
+		 *
+		 * Going back further than that is not possible: reverse_token() stops at the oldest buffered token, and
+		 * reverse_peek_token() returns token::null.
+		 *
+		 * Tokens still point into the mapped source, so copies of them stay valid for the lifetime of the stream. The
+		 * references returned by the stream, however, are only valid until the next call that moves or peeks ahead.
+		 */
+		class token_stream {
+		public:
+			static constexpr size_t default_capacity = 1024;
+			static constexpr size_t default_history = 64;
+		public:
+			token_stream(error_handler* const, const filesystem::file&, const size_t capacity = default_capacity, const size_t history = default_history);
+			token_stream(const token_stream&) = delete;
+			token_stream(token_stream&&) noexcept = default;
+			~token_stream() noexcept = default;
+
+			token_stream& operator=(const token_stream&) = delete;
+			token_stream& operator=(token_stream&&) noexcept = default;
+
+			/**
+			 * Opens the file for streaming, discarding any buffered tokens.
+			 * @return True if the file could be opened, false otherwise.
+			 */
+			bool open(void);
+
+			inline void mark(void) { this->m_marks.push_back(this->m_index); }
+			void rollback(void) noexcept;
+			inline void pop_mark(void) noexcept { return pop_marks(1); }
+			void pop_marks(size_t count = size_t(-1)) noexcept;
+
+			const token& current_token(void);
+			const token& next_token(size_t count = 1);
+			const token& reverse_token(size_t count = 1);
+			const token& peek_token(size_t count = 1);
+			const token& reverse_peek_token(size_t count = 1);
+
+			/// Index of the current token within the whole file
+			inline size_t get_index(void) const noexcept { return this->m_index; }
+
+			/// Number of tokens currently held in the buffer
+			inline size_t get_buffered(void) const noexcept { return this->m_end - this->m_begin; }
+
+			inline size_t get_capacity(void) const noexcept { return this->m_ring.size(); }
+
+			inline const tokenizer& get_tokenizer(void) const noexcept { return this->m_tokenizer; }
+			inline const source_map* get_source_map(void) const noexcept { return this->m_tokenizer.get_source_map(); }
+		private:
+			bool m_fill(const size_t index);
+			void m_trim(void) noexcept;
+			void m_grow(void);
+			inline const token& m_at(const size_t index) const noexcept { return this->m_ring[index & (this->m_ring.size() - 1)]; }
+		private:
+			tokenizer m_tokenizer;
+			std::vector<token> m_ring; // power-of-two sized ring buffer, indexed by token index
+			std::vector<token> m_scratch; // lexing target, copied into the ring
+			size_t m_history;
+			size_t m_begin = 0, m_end = 0; // token indices held in the ring: [m_begin, m_end)
+			size_t m_index = 0; // index of the current token
+			std::vector<size_t> m_marks; // stack of token indices; the lowest one pins the buffer
+		};
+	}
+}
+
+#endif /* SHIFT_TOKEN_STREAM_H_ */
@@ -3,25 +3,31 @@
  */
 
 #include "compiler/shift_tokenizer.h"
+#include "compiler/shift_lexer_tables.h"
+#include "compiler/shift_scanner.h"
+#include "compiler/shift_token_cache.h"
 #include "utils/utils.h"
-#include <fstream>
 #include <cctype>
 #include <algorithm>
+#include <limits>
+#include <memory>
+#include <thread>
 
 #define shift_tokenizer_can_peek(__peek_count) (((i)+(__peek_count)) < (filesize))
 #define shift_tokenizer_can_peek_() shift_tokenizer_can_peek(1)
-#define shift_tokenizer_peek(__peek_count) ((i + (__peek_count)) >= filesize ? char(0x0) : this->m_filedata[i+(__peek_count)])
+#define shift_tokenizer_peek(__peek_count) (chars[i+(__peek_count)]) // the source is zero-padded, no bounds check required
 #define shift_tokenizer_peek_() shift_tokenizer_peek(1)
 #define shift_tokenizer_is_whitespace(ch) is_whitespace_ext(ch, char)
-#define shift_tokenizer_advance(__count) i+=__count, col+=__count, current=this->m_filedata[i]
-#define shift_tokenizer_advance_() i++, col++, current=this->m_filedata[i]
+#define shift_tokenizer_advance(__count) i+=__count, col+=__count, current=chars[i]
+#define shift_tokenizer_advance_() i++, col++, current=chars[i]
 #define shift_tokenizer_pre_advance(__count) shift_tokenizer_advance(__count)
-#define shift_tokenizer_pre_advance_() ++i, ++col, current=this->m_filedata[i]
-#define shift_tokenizer_next_line() this->m_lines.push_back(std::string_view(&this->m_filedata[last_line], i-(last_line))), last_line = i+1, line++, col = 0
+#define shift_tokenizer_pre_advance_() ++i, ++col, current=chars[i]
+#define shift_tokenizer_next_line() last_line = i+1, line++, col = 0 // the line table itself is built by the source map
+#define shift_tokenizer_line_view(__begin, __end) std::string_view(&chars[__begin], (__end) - (__begin) - ((__end) > (__begin) && chars[(__end)-1] == char('\r'))) // source is not read in text mode; drop \r of \r\n
 
 #define shift_tokenizer_char_equal(__char, __eq) ((__char) == char((__eq)))
 #define shift_tokenizer_current_equal(__eq) shift_tokenizer_char_equal(current, __eq)
-#define shift_tokenizer_reverse(__count) i-=__count, col-=__count, current=this->m_filedata[i]
+#define shift_tokenizer_reverse(__count) i-=__count, col-=__count, current=chars[i]
 #define shift_tokenizer_reverse_() shift_tokenizer_reverse(1)
 
 #define shift_tokenizer_reverse_peek(__count) (__count) > i ? char(0x0) : chars[i-(__count)]
@@ -30,8 +36,8 @@
 #define shift_tokenizer_get_full_line(__out) \
 {\
 	size_t __my_line_size = i;\
-	for(;__my_line_size < filesize && !shift_tokenizer_char_equal(this->m_filedata[__my_line_size], '\n');__my_line_size++);\
-	__out = std::string_view(&this->m_filedata[last_line], __my_line_size-last_line);\
+	for(;__my_line_size < filesize && !shift_tokenizer_char_equal(chars[__my_line_size], '\n');__my_line_size++);\
+	__out = shift_tokenizer_line_view(last_line, __my_line_size);\
 }
 
  //#define shift_tokenizer_is_hex(__char) (is_between_in(__char, char('a'), char('f')) || is_between_in(__char, char('A'), char('F')) || is_between_in(__char, char('0'), char('9')))
@@ -47,24 +53,27 @@
 
 #define SHIFT_TOKENIZER_WARNING_LOG(__ERR__) 		if(m_error_handler) this->m_error_handler->stream() << __ERR__ << '\n', this->m_error_handler->flush_stream(error_handler::message_type::warning)
 
+// one message for the diagnostic, its line and the carets under it; lexing stops once it reaches the error limit (see m_lex())
 #define SHIFT_TOKENIZER_ERROR(_line_, _col_, _len_, __ERR__) \
 if(this->m_error_handler) {\
-	this->m_error_handler->stream() << SHIFT_TOKENIZER_ERROR_PREFIX(_line_, _col_) << __ERR__ << '\n'; this->m_error_handler->flush_stream(error_handler::message_type::error);\
-	std::string_view __temp_line; shift_tokenizer_get_full_line(__temp_line); SHIFT_TOKENIZER_ERROR_LOG(__temp_line);\
+	this->m_error_handler->stream() << SHIFT_TOKENIZER_ERROR_PREFIX(_line_, _col_) << __ERR__ << '\n';\
+	std::string_view __temp_line; shift_tokenizer_get_full_line(__temp_line); this->m_error_handler->stream() << __temp_line << '\n';\
 	this->m_error_handler->stream() << std::string((_col_)-1, ' ');\
 	this->m_error_handler->stream() << std::string(_len_, '^');\
 	this->m_error_handler->stream() << '\n';\
 	this->m_error_handler->flush_stream(error_handler::message_type::error);\
+	if (this->m_error_handler->is_error_limit_reached()) end = 0;\
 }
 
 #define SHIFT_TOKENIZER_WARNING(_line_, _col_, _len_, __ERR__) \
 if(this->m_error_handler) {\
-	this->m_error_handler->stream() << SHIFT_TOKENIZER_WARNING_PREFIX(_line_, _col_) << __ERR__ << '\n'; this->m_error_handler->flush_stream(error_handler::message_type::warning);\
-	std::string_view __temp_line; shift_tokenizer_get_full_line(__temp_line); SHIFT_TOKENIZER_WARNING_LOG(__temp_line);\
+	this->m_error_handler->stream() << SHIFT_TOKENIZER_WARNING_PREFIX(_line_, _col_) << __ERR__ << '\n';\
+	std::string_view __temp_line; shift_tokenizer_get_full_line(__temp_line); this->m_error_handler->stream() << __temp_line << '\n';\
 	this->m_error_handler->stream() << std::string((_col_)-1, ' ');\
 	this->m_error_handler->stream() << std::string(_len_, '^');\
 	this->m_error_handler->stream() << '\n';\
 	this->m_error_handler->flush_stream(error_handler::message_type::warning);\
+	if (this->m_error_handler->is_error_limit_reached()) end = 0;\
 }
 
 #define SHIFT_TOKENIZER_FATAL_ERROR(_line_, _col_, _len_, __ERR__) 		SHIFT_TOKENIZER_ERROR(_line_, _col_, _len_, __ERR__); if(m_error_handler) this->m_error_handler->print_exit_clear()
@@ -86,38 +95,32 @@ namespace shift {
 			return ret;
 		}
 
-		const token& tokenizer::token_at(const file_indexer index) const noexcept {
-			for (const token& token_ : this->m_tokens) {
-				if (token_.get_file_index() == index)
-					return token_;
-			}
-			return token::null;
+		std::size_t tokenizer::m_find_token(const file_indexer index) const noexcept {
+			return this->m_source ? this->m_source->token_index(this->m_source->offset(index)) : source_map::npos;
 		}
 
-		const token& tokenizer::token_before(const file_indexer index) const noexcept {
-			const token* last_token = &token::null;
+		std::size_t tokenizer::m_find_token(const token& token) const noexcept {
+			return this->m_source ? this->m_source->token_index(this->m_source->offset(token.get_data().data())) : source_map::npos;
+		}
 
-			for (const token& token : this->m_tokens) {
-				if (token.get_file_index() == index)
-					return *last_token;
-				last_token = &token;
-			}
+		const token& tokenizer::m_token_before(const std::size_t index) const noexcept {
+			return index == source_map::npos || index == 0 ? token::null : this->m_tokens[index - 1];
+		}
 
-			return token::null;
+		const token& tokenizer::m_token_after(const std::size_t index) const noexcept {
+			return index == source_map::npos || index + 1 >= this->m_tokens.size() ? token::null : this->m_tokens[index + 1];
 		}
 
-		const token& tokenizer::token_after(const file_indexer index) const noexcept {
-			bool next = false;
+		const token& tokenizer::token_at(const file_indexer index) const noexcept {
+			const std::size_t found = this->m_find_token(index);
+			return found == source_map::npos ? token::null : this->m_tokens[found];
+		}
 
-			for (const token& token : this->m_tokens) {
-				if (next)
-					return token;
-				if (token.get_file_index() == index)
-					next = true;
-			}
+		const token& tokenizer::token_before(const file_indexer index) const noexcept { return this->m_token_before(this->m_find_token(index)); }
 
-			return token::null;
-		}
+		const token& tokenizer::token_after(const file_indexer index) const noexcept { return this->m_token_after(this->m_find_token(index)); }
+
+		const token& tokenizer::token_before(const token& token) const noexcept { return this->m_token_before(this->m_find_token(token)); }
 
 		const token& tokenizer::peek_token(typename std::vector<token>::size_type count) const noexcept {
 			count = std::min<typename std::vector<token>::size_type>(count, this->cend() - this->m_token_index);
@@ -140,70 +143,382 @@ namespace shift {
 		}
 
 		void tokenizer::tokenize(void) {
-			if (!this->m_file) // Immediately exit if file does not exist
+			if (!this->open())
 				return;
 
+			const std::uint64_t key = this->m_cache ? token_cache::key(this->m_filedata, std::filesystem::relative(this->m_file.raw_path()).string()) : 0;
+			if (this->m_cache && this->m_cache->load(key, *this->m_source, this->m_tokens, this->m_error_handler)) {
+				this->m_lex_state = this->m_lex_state_at(this->m_filedata.size());
+			} else {
+				// diagnostics meant for the cache are recorded with every warning, so that the entry serves any flags
+				error_handler recorded;
+				recorded.set_warnings(true);
+				error_handler* const handler = this->m_error_handler;
+				if (this->m_cache)
+					this->m_error_handler = &recorded;
+
+				size_t threads = this->m_threads ? this->m_threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+				threads = std::min<size_t>(threads, std::max<size_t>(this->m_filedata.size() / parallel_chunk_size, 1));
+
+				if (threads > 1)
+					this->m_lex_parallel(threads);
+				else
+					this->m_lex(this->m_tokens, std::numeric_limits<size_t>::max(), this->m_filedata.size());
+
+				this->m_decode_literals(this->m_tokens.cbegin(), this->m_tokens.cend());
+
+				if (this->m_cache) {
+					this->m_error_handler = handler;
+					this->m_cache->store(key, *this->m_source, this->m_tokens, recorded);
+					token_cache::replay(recorded, handler);
+				}
+			}
+
+			{ // index the tokens, so that positions can be mapped back to them
+				std::vector<std::uint32_t> offsets;
+				offsets.reserve(this->m_tokens.size());
+				for (const token& token : this->m_tokens)
+					offsets.push_back(static_cast<std::uint32_t>(token.get_data().data() - this->m_filedata.data()));
+				this->m_source->set_token_offsets(std::move(offsets));
+			}
+
+			this->m_token_index = this->m_tokens.cbegin();
+		}
+
+		tokenizer::token_range tokenizer::edit(const size_t offset, size_t removed, const std::string_view inserted) {
+			if (!this->m_source || !this->is_lexed() || offset > this->m_filedata.size())
+				return token_range();
+
+			std::vector<std::uint32_t> offsets = this->m_source->token_offsets();
+			if (offsets.size() != this->m_tokens.size())
+				return token_range();
+
+			const size_t old_size = this->m_filedata.size();
+			const size_t token_index = size_t(this->m_token_index - this->m_tokens.cbegin());
+			removed = std::min(removed, old_size - offset);
+			const std::int64_t delta = std::int64_t(inserted.size()) - std::int64_t(removed);
+
+			// the first token that ends close enough to the edit to have seen it; the lexer is in its initial state at its start,
+			// as at the start of any token
+			// (a token is taken to end where the next one starts, which is never too early)
+			size_t first = 0;
+			if (offset >= max_lookahead && !offsets.empty())
+				first = size_t(std::upper_bound(offsets.cbegin() + 1, offsets.cend(), offset - max_lookahead) - (offsets.cbegin() + 1));
+			// (with no token before the edit, the edit may lie in a comment, so lexing restarts at the start of the file)
+			const size_t restart = first < offsets.size() && offsets[first] <= offset ? offsets[first] : 0;
+
+			if (!this->m_source->edit(offset, removed, inserted))
+				return token_range();
+			this->m_filedata = this->m_source->source();
+			this->m_lex_state = this->m_lex_state_at(restart);
+
+			// lex until a token starts where one did before the edit, from which point on both lists are the same
+			std::vector<token> relexed;
+			size_t last = offsets.size(); // first old token kept after the edit
+			while (this->m_lex(relexed, 1, this->m_filedata.size())) {
+				const size_t start = size_t(relexed.back().get_data().data() - this->m_filedata.data());
+				if (start < offset + inserted.size())
+					continue;
+
+				const std::int64_t old_start = std::int64_t(start) - delta;
+				const auto it = std::lower_bound(offsets.cbegin() + first, offsets.cend(), old_start);
+				if (it != offsets.cend() && std::int64_t(*it) == old_start) {
+					last = size_t(it - offsets.cbegin());
+					relexed.pop_back();
+					break;
+				}
+			}
+
+			// tokens that were lexed again only because the edit was within their lookahead, and came out as they were, are left
+			// out of the range returned
+			size_t same = 0;
+			for (const char* const chars = this->m_filedata.data(); same < relexed.size() && first + same < last; same++) {
+				const token& before = this->m_tokens[first + same], & after = relexed[same];
+				if (offsets[first + same] + before.get_data().size() > offset || size_t(after.get_data().data() - chars) != offsets[first + same]
+					|| after.get_data().size() != before.get_data().size() || after.get_token_type() != before.get_token_type())
+					break;
+			}
+
+			{ // point the kept tokens into the new buffer
+				const char* const chars = this->m_filedata.data();
+				const auto rebase = [chars](const token& token, const size_t offset) {
+					const std::string_view data(chars + offset, token.get_data().size());
+					return token.is_identifier() ? compiler::token(data, token.get_symbol()) : compiler::token(data, token.get_token_type());
+				};
+
+				for (size_t i = 0; i < first; i++)
+					this->m_tokens[i] = rebase(this->m_tokens[i], offsets[i]);
+
+				for (size_t i = last; i < offsets.size(); i++) {
+					offsets[i] = static_cast<std::uint32_t>(offsets[i] + delta);
+					this->m_tokens[i] = rebase(this->m_tokens[i], offsets[i]);
+				}
+			}
+
+			this->m_source->literals().edit(static_cast<std::uint32_t>(restart), static_cast<std::uint32_t>(last < offsets.size() ? offsets[last] - delta : old_size), delta);
+
+			this->m_tokens.erase(this->m_tokens.cbegin() + first, this->m_tokens.cbegin() + last);
+			this->m_tokens.insert(this->m_tokens.cbegin() + first, relexed.cbegin(), relexed.cend());
+			this->m_decode_literals(this->m_tokens.cbegin() + first, this->m_tokens.cbegin() + first + relexed.size());
+
+			offsets.erase(offsets.cbegin() + first, offsets.cbegin() + last);
+			offsets.insert(offsets.cbegin() + first, relexed.size(), 0);
+			for (size_t i = 0; i < relexed.size(); i++)
+				offsets[first + i] = static_cast<std::uint32_t>(relexed[i].get_data().data() - this->m_filedata.data());
+			this->m_source->set_token_offsets(std::move(offsets));
+
+			this->m_lex_state = this->m_lex_state_at(this->m_filedata.size());
+			utils::clear_stack(this->m_token_marks);
+			this->m_token_index = this->m_tokens.cbegin() + std::min(token_index, this->m_tokens.size());
+
+			token_range range;
+			range.begin = first + same;
+			range.removed = last - first - same;
+			range.inserted = relexed.size() - same;
+			return range;
+		}
+
+		bool tokenizer::open(void) {
 			// Clear all class data in case this function has been called more than once
 			this->m_tokens.clear();
-			std::string().swap(this->m_filedata);
-			this->m_lines.clear();
+			this->m_filedata = std::string_view();
+			this->m_source.reset();
+			this->m_lex_state = lex_state();
 			utils::clear_stack(this->m_token_marks);
 
 			this->m_token_index = this->m_tokens.cbegin();
 
-			std::uintmax_t filesize = this->m_file.size(); // retrieves real size of file on disk; we know it must be at least this large
-			{ // read the file
-				std::ifstream input_file(this->m_file.raw_path(), std::ios_base::in);
+			if (!this->m_file) // Immediately exit if file does not exist
+				return false;
 
-				// reserve correct amount of bytes within file data string
-				this->m_filedata.resize(filesize);
+			{ // map the file; tokens and lines will point directly into the mapping
+				std::shared_ptr<filesystem::mapped_file> source = std::make_shared<filesystem::mapped_file>();
+				if (!source->open(this->m_file))
+					return false;
 
-				input_file.read(this->m_filedata.data(), filesize); // read the file fully
+				// tokens store 32-bit lengths and the source map 32-bit offsets
+				if (source->size() > std::numeric_limits<std::uint32_t>::max()) {
+					SHIFT_TOKENIZER_ERROR_LOG("error: " << std::filesystem::relative(this->m_file.raw_path()).string() << ": file is too large (" << source->size() << " bytes)");
+					return false;
+				}
 
-				filesize = std::uintmax_t(input_file.gcount()); // change file size to number of characters read
-				this->m_filedata.resize(filesize); // resize the string to the right size
-				input_file.close();
+				this->m_source = std::make_shared<source_map>(std::move(source));
+				this->m_filedata = this->m_source->source();
 			}
 
-			{ // tokenizing
-				size_t last_line = 0; // index of character after last \n
-				char current = this->m_filedata[0]; // Current character (i.e. cursor)
-				size_t i, line, col; // index (starts at 0), line # (starts at 1), column # (starts at 1)
+			this->m_lex_state.open = true;
+			return true;
+		}
 
-				this->m_lines.reserve(utils::count(this->m_filedata, std::string_view("\n")) + 1);
+		size_t tokenizer::lex(std::vector<token>& out, const size_t count) {
+			const size_t first = out.size();
+			const size_t lexed = this->m_lex(out, count, this->m_filedata.size());
+			this->m_decode_literals(out.cbegin() + first, out.cend());
+			return lexed;
+		}
 
-				for (i = 0, line = 1, col = 1; i < filesize; shift_tokenizer_advance_()) {
-					if (shift_tokenizer_is_whitespace(current)) {
-						if (shift_tokenizer_current_equal('\n')) {
-							shift_tokenizer_next_line();
-							// col++; // col will be incremented to 1 by shift_tokenizer_advance_() in the for loop
-						} else if (shift_tokenizer_current_equal('\t')) {
-							col += 3; // tabs are 4 spaces. col with be incremented the 4th time by shift_tokenizer_advance_() in the for loop
-						}
+		void tokenizer::m_decode_literals(typename std::vector<token>::const_iterator begin, const typename std::vector<token>::const_iterator end) {
+			literal_table& literals = this->m_source->literals();
+
+			for (; begin != end; ++begin) {
+				literal::literal_kind kind;
+				switch (begin->get_token_type()) {
+					case token::token_type::NUMBER_LITERAL:
+					case token::token_type::BINARY_NUMBER:
+					case token::token_type::HEX_NUMBER:
+						kind = literal::INTEGER;
+						break;
+					case token::token_type::FLOAT:
+						kind = literal::FLOAT;
+						break;
+					case token::token_type::DOUBLE:
+						kind = literal::DOUBLE;
+						break;
+					case token::token_type::STRING_LITERAL:
+						kind = literal::STRING;
+						break;
+					case token::token_type::CHAR_LITERAL:
+						kind = literal::CHAR;
+						break;
+					default:
 						continue;
+				}
+
+				literals.add(static_cast<std::uint32_t>(begin->get_data().data() - this->m_filedata.data()), kind, begin->get_data());
+			}
+		}
+
+		tokenizer::lex_state tokenizer::m_lex_state_at(const size_t index) const noexcept {
+			// the lexer keeps its line and column in step with the source map, so its state anywhere can be recovered from it
+			const file_indexer position = this->m_source->position(index);
+
+			lex_state state;
+			state.index = index;
+			state.line = position.line;
+			state.col = position.col;
+			state.last_line = size_t(this->m_source->line(position.line).data() - this->m_filedata.data());
+			state.open = true;
+			return state;
+		}
+
+		void tokenizer::m_lex_parallel(const size_t threads) {
+			const char* const chars = this->m_filedata.data();
+			const size_t filesize = this->m_filedata.size();
+
+			struct chunk {
+				size_t begin = 0, stop = 0; // lexed from begin until the first token boundary at or past stop
+				size_t end = 0; // where lexing actually stopped
+				std::vector<token> tokens;
+				std::unique_ptr<error_handler> errors;
+			};
+
+			// only split at line starts, where the lexer is in its initial state unless a comment or a literal spans the line break
+			std::vector<chunk> chunks;
+			for (size_t begin = 0; begin < filesize;) {
+				size_t stop = begin + filesize / threads;
+				if (stop < filesize)
+					stop = std::min(size_t(scanner::find_first_of<'\n'>(chars + stop, chars + filesize) - chars) + 1, filesize);
+				else
+					stop = filesize;
+
+				chunks.emplace_back();
+				chunks.back().begin = begin;
+				chunks.back().stop = stop;
+				begin = stop;
+			}
+
+			const auto lex_chunk = [this](chunk& chunk) {
+				if (this->m_error_handler) // diagnostics are held back until it is known whether the chunk was lexed from the right place
+					chunk.errors = std::make_unique<error_handler>(this->m_error_handler->branch());
+
+				tokenizer lexer(chunk.errors.get(), this->m_file);
+				lexer.m_source = this->m_source;
+				lexer.m_filedata = this->m_filedata;
+				lexer.m_lex_state = this->m_lex_state_at(chunk.begin);
+
+				chunk.tokens.reserve((chunk.stop - chunk.begin) / 4);
+				lexer.m_lex(chunk.tokens, std::numeric_limits<size_t>::max(), chunk.stop);
+				chunk.end = lexer.m_lex_state.index;
+			};
+
+			{ // the first chunk is never speculative; lex it on this thread
+				std::vector<std::thread> workers;
+				workers.reserve(chunks.size() - 1);
+				for (size_t index = 1; index < chunks.size(); index++)
+					workers.emplace_back(lex_chunk, std::ref(chunks[index]));
+
+				lex_chunk(chunks.front());
+
+				for (std::thread& worker : workers)
+					worker.join();
+			}
+
+			size_t total = 0;
+			for (const chunk& chunk : chunks)
+				total += chunk.tokens.size();
+			this->m_tokens.reserve(total);
+
+			size_t index = 0; // where a serial run would be
+			for (chunk& chunk : chunks) {
+				if (this->m_error_handler && this->m_error_handler->is_error_limit_reached())
+					break; // as a serial run would have stopped here
+
+				if (index >= chunk.stop) // swallowed by a comment or a literal of an earlier chunk
+					continue;
+
+				if (index == chunk.begin) {
+					this->m_tokens.insert(this->m_tokens.end(), chunk.tokens.cbegin(), chunk.tokens.cend());
+					if (chunk.errors)
+						this->m_error_handler->append(*chunk.errors);
+					index = chunk.end;
+					continue;
+				}
+
+				// the previous chunk ended inside this one, so the speculation was wrong up to some point; lex serially from where
+				// the previous chunk ended, until a token starts where the speculative run started one too, as both runs are the
+				// same from there on
+				this->m_lex_state = this->m_lex_state_at(index);
+
+				if (chunk.errors && !chunk.errors->get_messages().empty()) {
+					// unless the speculative run reported something, which can not be told apart from what it reported before
+					// that point
+					this->m_lex(this->m_tokens, std::numeric_limits<size_t>::max(), chunk.stop);
+					index = this->m_lex_state.index;
+					continue;
+				}
+
+				bool synced = false;
+				while (!synced && this->m_lex(this->m_tokens, 1, chunk.stop)) {
+					const char* const data = this->m_tokens.back().get_data().data();
+					const auto it = std::lower_bound(chunk.tokens.cbegin(), chunk.tokens.cend(), data, [](const token& token, const char* const data) {
+						return token.get_data().data() < data;
+						});
+
+					if (it != chunk.tokens.cend() && it->get_data().data() == data) {
+						this->m_tokens.insert(this->m_tokens.end(), it + 1, chunk.tokens.cend());
+						synced = true;
 					}
+				}
 
-					if (isalpha(current) || shift_tokenizer_current_equal('_')) {
-						const size_t old_col = col;
-						const size_t old_i = i;
+				index = synced ? chunk.end : this->m_lex_state.index;
+			}
 
-						for (shift_tokenizer_pre_advance_(); (i < filesize) && (isalnum(current) || shift_tokenizer_current_equal('_'));
-							shift_tokenizer_advance_());
+			this->m_lex_state = this->m_lex_state_at(filesize);
+			this->m_lex_state.index = std::max(index, filesize);
+		}
 
-						shift_tokenizer_reverse_();
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::IDENTIFIER, { line,
-								old_col }));
+		size_t tokenizer::m_lex(std::vector<token>& out, const size_t count, const size_t stop) {
+			if (!this->m_lex_state.open || this->m_lex_state.index >= this->m_filedata.size())
+				return 0;
+
+			// The mapping is followed by at least filesystem::mapped_file::padding zero bytes, so peeking never has to be bounds checked
+			const char* const chars = this->m_filedata.data();
+			const size_t filesize = this->m_filedata.size();
+
+			const size_t first = out.size();
+			const size_t limit = count > std::numeric_limits<size_t>::max() - first ? std::numeric_limits<size_t>::max() : first + count;
+			size_t end = stop; // brought down to stop after the current token once the error limit is reached
+
+			// resume where the last call stopped
+			size_t i = this->m_lex_state.index; // index (starts at 0)
+			size_t line = this->m_lex_state.line; // line # (starts at 1)
+			size_t col = this->m_lex_state.col; // column # (starts at 1)
+			size_t last_line = this->m_lex_state.last_line; // index of character after last \n
+			char current = chars[i]; // Current character (i.e. cursor)
+
+			for (; i < end && out.size() < limit; shift_tokenizer_advance_()) {
+				switch (lexer::actions[static_cast<unsigned char>(current)]) {
+					case lexer::NEWLINE:
+						shift_tokenizer_next_line();
+						// col++; // col will be incremented to 1 by shift_tokenizer_advance_() in the for loop
+						continue;
+					case lexer::BLANK: {
+						// skip the whole run of blanks; tabs are 4 spaces
+						size_t tabs = 0;
+						const size_t run = size_t(scanner::skip_blanks(&chars[i], tabs) - &chars[i]);
+						shift_tokenizer_advance(run - 1); // the last blank is skipped by shift_tokenizer_advance_() in the for loop
+						col += tabs * 3;
 						continue;
 					}
+					case lexer::IDENTIFIER: {
+						const size_t old_i = i;
 
-					if (isdigit(current)) {
-						const size_t old_col = col;
+						{ // the zero padding after the source stops the scan
+							const size_t length = size_t(scanner::skip_identifier(&chars[i + 1]) - &chars[i]);
+							if (length > token::max_identifier_length)
+								SHIFT_TOKENIZER_ERROR(line, col, 1, "Identifier is too long (more than " << token::max_identifier_length << " characters)");
+							shift_tokenizer_advance(length - 1);
+						}
+						out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::IDENTIFIER));
+						continue;
+					}
+					case lexer::NUMBER: {
 						const size_t old_i = i;
 
-						for (shift_tokenizer_pre_advance_(); i < filesize && isdigit(current); shift_tokenizer_advance_());
+						for (shift_tokenizer_pre_advance_(); i < filesize && scanner::is_digit(current); shift_tokenizer_advance_());
 
 						if ((shift_tokenizer_current_equal('b') || shift_tokenizer_current_equal('B'))
-							&& ((i - old_i) == 1 && this->m_filedata[old_i] == char('0'))) {
+							&& ((i - old_i) == 1 && chars[old_i] == char('0'))) {
 							// binary number
 							for (shift_tokenizer_pre_advance_(); i < filesize && shift_tokenizer_is_binary(current); shift_tokenizer_advance_());
 
@@ -214,10 +529,9 @@ namespace shift {
 							}
 
 							shift_tokenizer_reverse_();
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::BINARY_NUMBER, {
-									line, old_col }));
+							out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::BINARY_NUMBER));
 						} else if ((shift_tokenizer_current_equal('x') || shift_tokenizer_current_equal('X'))
-							&& ((i - old_i) == 1 && this->m_filedata[old_i] == char('0'))) {
+							&& ((i - old_i) == 1 && chars[old_i] == char('0'))) {
 							// hex number
 							for (shift_tokenizer_pre_advance_(); i < filesize && shift_tokenizer_is_hex(current); shift_tokenizer_advance_());
 
@@ -228,374 +542,96 @@ namespace shift {
 							}
 
 							shift_tokenizer_reverse_();
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::HEX_NUMBER, { line,
-									old_col }));
-						} else if (shift_tokenizer_current_equal('.') && isdigit(shift_tokenizer_peek_())) {
-							for (shift_tokenizer_pre_advance_(); i < filesize && isdigit(current); shift_tokenizer_advance_());
+							out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::HEX_NUMBER));
+						} else if (shift_tokenizer_current_equal('.') && scanner::is_digit(shift_tokenizer_peek_())) {
+							for (shift_tokenizer_pre_advance_(); i < filesize && scanner::is_digit(current); shift_tokenizer_advance_());
 
 							if (shift_tokenizer_current_equal('f') || shift_tokenizer_current_equal('F')) {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::FLOAT, { line,
-										old_col }));
+								out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::FLOAT));
 							} else if (shift_tokenizer_current_equal('d') || shift_tokenizer_current_equal('D')) {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::DOUBLE, { line,
-										old_col }));
+								out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::DOUBLE));
 							} else {
 								shift_tokenizer_reverse_();
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::FLOAT, { line,
-										old_col }));
+								out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::FLOAT));
 							}
 
 						} else if (shift_tokenizer_current_equal('f') || shift_tokenizer_current_equal('F')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::FLOAT, { line,
-									old_col }));
+							out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::FLOAT));
 						} else if (shift_tokenizer_current_equal('d') || shift_tokenizer_current_equal('D')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::DOUBLE, { line,
-									old_col }));
+							out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::DOUBLE));
 						} else {
 							shift_tokenizer_reverse_();
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::NUMBER_LITERAL, {
-									line, old_col }));
+							out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::NUMBER_LITERAL));
 						}
 						continue;
 					}
-
-					if (shift_tokenizer_current_equal(';')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::SEMICOLON, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('!')) {
-						if (shift_tokenizer_char_equal(shift_tokenizer_peek_(), '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::NOT_EQUAL, { line, col }));
-							shift_tokenizer_advance_();
-							continue;
-						}
-
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::NOT, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('{')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::LEFT_SCOPE_BRACKET, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('}')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::RIGHT_SCOPE_BRACKET, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('(')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::LEFT_BRACKET, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal(')')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::RIGHT_BRACKET, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('[')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::LEFT_SQUARE_BRACKET, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal(']')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::RIGHT_SQUARE_BRACKET, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('.')) {
-						if (isdigit(shift_tokenizer_peek_())) {
-							const size_t old_col = col;
+					case lexer::DOT:
+						if (scanner::is_digit(shift_tokenizer_peek_())) {
 							const size_t old_i = i;
 
 							// We already know the next character is a digit
-							for (shift_tokenizer_pre_advance(2); i < filesize && isdigit(current); shift_tokenizer_advance_());
+							for (shift_tokenizer_pre_advance(2); i < filesize && scanner::is_digit(current); shift_tokenizer_advance_());
 
 							if (shift_tokenizer_current_equal('f') || shift_tokenizer_current_equal('F')) {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::FLOAT, { line,
-										old_col }));
+								out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::FLOAT));
 							} else if (shift_tokenizer_current_equal('d') || shift_tokenizer_current_equal('D')) {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::DOUBLE, { line,
-										old_col }));
+								out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::DOUBLE));
 							} else {
 								shift_tokenizer_reverse_();
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::DOUBLE, { line,
-										old_col }));
+								out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::DOUBLE));
 							}
 
 							continue;
 						}
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::DOT, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('=')) {
-						const char next = shift_tokenizer_peek_();
-
-						// CHECK FOR GREATHER THAN, LESS THAN, MODULO, !=, ETCCCCCC
-						//
-						// (actually, not != or -=, since it could be:  "int i =! varName;" = "int i = !varName;" or "int i =- varName;" = "int i = -varName;")
-
-						if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::EQUALS_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '%')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::MODULO_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '*')) // If pointers are added into the language, =* might count as a dereferencing and not *=
-						{
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::MULTIPLY_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '&')) // If pointers are added into the language, =& might count as 'getting a pointer to' and not &=
-						{
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::AND_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '|')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::OR_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '^')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::XOR_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '<')) {
-							if (shift_tokenizer_char_equal(shift_tokenizer_peek(2), '<')) {
-								m_tokens.push_back(
-									token(std::string_view(&this->m_filedata[i], 3), token::token_type::SHIFT_LEFT_EQUALS, { line, col }));
-								shift_tokenizer_advance(2);
-							} else {
-								m_tokens.push_back(
-									token(std::string_view(&this->m_filedata[i], 2), token::token_type::LESS_THAN_OR_EQUAL, { line, col }));
-								shift_tokenizer_advance_();
-							}
-
-						} else if (shift_tokenizer_char_equal(next, '>')) {
-							if (shift_tokenizer_char_equal(shift_tokenizer_peek(2), '>')) {
-								m_tokens.push_back(
-									token(std::string_view(&this->m_filedata[i], 3), token::token_type::SHIFT_RIGHT_EQUALS, { line, col }));
-								shift_tokenizer_advance(2);
-							} else {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::GREATER_THAN_OR_EQUAL, { line,
-										col }));
-								shift_tokenizer_advance_();
-							}
-
-						} else if (shift_tokenizer_char_equal(next, '/')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::DIVIDE_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '+') && !shift_tokenizer_char_equal(shift_tokenizer_peek(2), '+')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::PLUS_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						}
-						//
-						//					Cannot transform =- to -=
-						//					Reason:
-						//					i =- 3; // -= 3 OR = -3 ? (since white spaces are ignored)
-						//					
-						//					else if (shift_tokenizer_char_equal(next, '-')) {
-						//						m_tokens.push_back(
-						//								token(std::string_view({next}) + current, token::token_type::MINUS_EQUALS, {line, col}));
-						//						shift_tokenizer_advance_();
-						//					}
-						else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::EQUALS, { line, col }));
-						}
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('&')) {
-						const char next = shift_tokenizer_peek_();
-						if (shift_tokenizer_char_equal(next, '&')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::AND_AND, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::AND_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::AND, { line, col }));
-						}
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('|')) {
+						break;
+					case lexer::SLASH: {
 						const char next = shift_tokenizer_peek_();
-						if (shift_tokenizer_char_equal(next, '|')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::OR_OR, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::OR_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::OR, { line, col }));
-						}
-
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('^')) {
-						if (shift_tokenizer_char_equal(shift_tokenizer_peek_(), '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::XOR_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::XOR, { line, col }));
-						}
-
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('?')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::QUESTION_MARK, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('~')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::FLIP_BITS, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('\\')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::BACKSLASH, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal(':')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::COLON, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal(',')) {
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::COMMA, { line, col }));
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('-')) {
-						const char next = shift_tokenizer_peek_();
-
-						if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::MINUS_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '-')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::MINUS_MINUS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::MINUS, { line, col }));
-						}
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('+')) {
-						const char next = shift_tokenizer_peek_();
-						if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::PLUS_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '+')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::PLUS_PLUS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::PLUS, { line, col }));
-						}
-
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('*')) {
-						if (shift_tokenizer_char_equal(shift_tokenizer_peek_(), '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::MULTIPLY_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::MULTIPLY, { line, col }));
-						}
-
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('>')) {
-						const char next = shift_tokenizer_peek_();
-						if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(
-								token(std::string_view(&this->m_filedata[i], 2), token::token_type::GREATER_THAN_OR_EQUAL, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '>')) {
-							if (shift_tokenizer_char_equal(shift_tokenizer_peek(2), '=')) {
-								m_tokens.push_back(
-									token(std::string_view(&this->m_filedata[i], 3), token::token_type::SHIFT_RIGHT_EQUALS, { line, col }));
-								shift_tokenizer_advance(2);
-							} else {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::SHIFT_RIGHT, { line, col }));
-								shift_tokenizer_advance_();
-							}
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::GREATER_THAN, { line, col }));
-						}
-
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('<')) {
-						const char next = shift_tokenizer_peek_();
-						if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(
-								token(std::string_view(&this->m_filedata[i], 2), token::token_type::LESS_THAN_OR_EQUAL, { line, col }));
-							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '<')) {
-							if (shift_tokenizer_char_equal(shift_tokenizer_peek(2), '=')) {
-								m_tokens.push_back(
-									token(std::string_view(&this->m_filedata[i], 3), token::token_type::SHIFT_LEFT_EQUALS, { line, col }));
-								shift_tokenizer_advance(2);
-							} else {
-								m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::SHIFT_LEFT, { line, col }));
-								shift_tokenizer_advance_();
-							}
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::LESS_THAN, { line, col }));
-						}
-
-						continue;
-					}
-
-					if (shift_tokenizer_current_equal('%')) {
-						if (shift_tokenizer_char_equal(shift_tokenizer_peek_(), '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::MODULO_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::MODULO, { line, col }));
+						if (shift_tokenizer_char_equal(next, '/')) {
+							// single line comment, skip to the end of the line
+							const size_t length = size_t(scanner::find_first_of<'\n'>(&chars[i + 2], chars + filesize) - &chars[i]);
+							shift_tokenizer_advance(length);
+							shift_tokenizer_next_line();
+							continue;
 						}
 
-						continue;
-					}
+						if (shift_tokenizer_char_equal(next, '*')) {
+							// Multi line comment, loop until next "*/", only stopping at '*' and new lines
+							for (shift_tokenizer_pre_advance(2); i < filesize; shift_tokenizer_advance_()) {
+								const size_t skipped = size_t(scanner::find_first_of<'*', '\n'>(&chars[i], chars + filesize) - &chars[i]);
+								shift_tokenizer_advance(skipped);
 
-					if (shift_tokenizer_current_equal('/')) {
-						const char next = shift_tokenizer_peek_();
-						if (shift_tokenizer_char_equal(next, '/')) {
-							// single line comment, loop until line is finished
-							for (shift_tokenizer_pre_advance(2); i < filesize && !shift_tokenizer_current_equal('\n'); shift_tokenizer_advance_());
-							shift_tokenizer_next_line();
-						} else if (shift_tokenizer_char_equal(next, '*')) {
-							// Multi line comment, loop until next "*/"
-							for (shift_tokenizer_pre_advance(2);
-								i < filesize && !(shift_tokenizer_current_equal('*') && shift_tokenizer_char_equal(shift_tokenizer_peek_(), '/'));
-								shift_tokenizer_advance_()) {
 								if (shift_tokenizer_current_equal('\n')) {
 									shift_tokenizer_next_line();
+									continue;
+								}
+
+								col += scanner::count(&chars[i - skipped], &chars[i], '\t') * 3; // tabs are 4 spaces
+								if (i >= filesize || shift_tokenizer_char_equal(shift_tokenizer_peek_(), '/')) {
+									break;
 								}
 							}
 							shift_tokenizer_advance_();
-						} else if (shift_tokenizer_char_equal(next, '=')) {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 2), token::token_type::DIVIDE_EQUALS, { line, col }));
-							shift_tokenizer_advance_();
-						} else {
-							m_tokens.push_back(token(std::string_view(&this->m_filedata[i], 1), token::token_type::DIVIDE, { line, col }));
+							continue;
 						}
-						continue;
+						break;
 					}
-
-					if (shift_tokenizer_current_equal('"')) {
+					case lexer::OPERATOR:
+						break;
+					case lexer::STRING: {
 						bool string_end = false;
 
 						const size_t old_col = col;
 						const size_t old_i = i;
 
 						for (shift_tokenizer_pre_advance_(); i < filesize; shift_tokenizer_advance_()) {
+							// skip the plain contents of the string
+							const size_t skipped = size_t(scanner::find_first_of<'"', '\\', '\n'>(&chars[i], chars + filesize) - &chars[i]);
+							shift_tokenizer_advance(skipped);
+							if (i >= filesize)
+								break;
+							if (!shift_tokenizer_current_equal('\n')) // the column is reset at the end of the line anyway
+								col += scanner::count(&chars[i - skipped], &chars[i], '\t') * 3; // tabs are 4 spaces
+
 							if (shift_tokenizer_current_equal('\\')) {
 								if (!shift_tokenizer_can_peek_()) {
 									// error, unfinished string
@@ -625,6 +661,8 @@ namespace shift {
 										break;
 								}
 
+								if (shift_tokenizer_current_equal('\t'))
+									col += 3; // tabs are 4 spaces
 								continue;
 							}
 
@@ -646,13 +684,13 @@ namespace shift {
 							}
 						}
 
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::STRING_LITERAL, { line,
-								old_col }));
+						if (shift_tokenizer_current_equal('\n'))
+							shift_tokenizer_next_line(); // the unterminated string ends with the line terminator
+
+						out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::STRING_LITERAL));
 						continue;
 					}
-
-					if (shift_tokenizer_current_equal('\'')) {
-						const size_t old_col = col;
+					case lexer::CHAR: {
 						const size_t old_i = i;
 
 						shift_tokenizer_advance_();
@@ -684,27 +722,49 @@ namespace shift {
 							continue;
 						}
 
+						// keep the line and column in step when the character is a tab or a line terminator
+						if (shift_tokenizer_current_equal('\t'))
+							col += 3; // tabs are 4 spaces
+						else if (shift_tokenizer_current_equal('\n'))
+							shift_tokenizer_next_line();
+
 						shift_tokenizer_advance_();
 
 						if (!shift_tokenizer_current_equal('\'')) {
 							if (this->m_error_handler) {
 								SHIFT_TOKENIZER_ERROR(line, col, 1, "Expected ''', got '" << current << "'");
 							}
+
+							if (shift_tokenizer_current_equal('\t'))
+								col += 3;
+							else if (shift_tokenizer_current_equal('\n'))
+								shift_tokenizer_next_line();
 						}
 
-						m_tokens.push_back(token(std::string_view(&this->m_filedata[old_i], i - old_i + 1), token::token_type::CHAR_LITERAL, { line,
-								old_col }));
+						out.push_back(token(std::string_view(&chars[old_i], i - old_i + 1), token::token_type::CHAR_LITERAL));
 						continue;
 					}
-
-					// ALL OTHER CHARACTERS
-					if (this->m_error_handler) {
-						SHIFT_TOKENIZER_ERROR(line, col, 1, "Unexpected symbol: '" << current << "'");
-					}
+					default:
+						// ALL OTHER CHARACTERS
+						if (this->m_error_handler) {
+							SHIFT_TOKENIZER_ERROR(line, col, 1, "Unexpected symbol: '" << current << "'");
+						}
+						continue;
 				}
-				shift_tokenizer_next_line();
+
+				// operators and punctuation, longest match first
+				const lexer::operator_match match = lexer::match_operator(&chars[i]);
+				out.push_back(token(std::string_view(&chars[i], match.length), match.type));
+				shift_tokenizer_advance(match.length - 1);
 			}
-			this->m_token_index = this->m_tokens.cbegin();
+			if (i >= filesize)
+				shift_tokenizer_next_line();
+
+			this->m_lex_state.index = i;
+			this->m_lex_state.line = line;
+			this->m_lex_state.col = col;
+			this->m_lex_state.last_line = last_line;
+			return out.size() - first;
 		}
 
 	}
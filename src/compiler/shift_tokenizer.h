@@ -8,9 +8,16 @@
 #include "utils/utils.h"
 
 #include "filesystem/file.h"
+#include "filesystem/mapped_file.h"
 
 #include "compiler/shift_error_handler.h"
+#include "compiler/shift_keywords.h"
+#include "compiler/shift_source_map.h"
+#include "compiler/shift_symbols.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <type_traits>
 
  /** Namespace shift */
@@ -18,23 +25,6 @@ namespace shift {
 	/** Namespace compiler */
 	namespace compiler {
 
-		struct file_indexer {
-			size_t line = 0, col = 0;
-
-			constexpr inline bool operator==(const file_indexer other) const noexcept { return this->col == other.col && this->line == other.line; }
-
-			constexpr inline bool operator!=(const file_indexer& other) const noexcept { return !this->operator==(other); }
-
-			constexpr inline bool operator>(const file_indexer other) const noexcept { return this->line == other.line ? this->col > other.col : this->line > other.line; }
-
-			constexpr inline bool operator<(const file_indexer other) const noexcept { return this->line == other.line ? this->col < other.col : this->line < other.line; }
-
-			constexpr inline bool operator>=(const file_indexer& other) const noexcept { return !this->operator<(other); }
-
-			constexpr inline bool operator<=(const file_indexer& other) const noexcept { return !this->operator>(other); }
-
-		};
-
 		struct token {
 		public:
 			/**
@@ -119,11 +109,17 @@ namespace shift {
 			};
 		public:
 			static const token null;
+
+			/// Longest identifier a token can hold; the tokenizer reports longer ones, and only their beginning is kept
+			static constexpr size_t max_identifier_length = UINT16_MAX;
 		public:
 			constexpr token(void) noexcept = default;
-			inline token(const std::string& str, token_type type, const file_indexer index) noexcept;
-			constexpr inline token(const std::string_view str, token_type type, const file_indexer index) noexcept;
-			token(const std::string&& str, token_type type, const file_indexer index) noexcept = delete;
+			inline token(const std::string& str, token_type type) noexcept;
+			constexpr inline token(const std::string_view str, token_type type) noexcept;
+
+			/// Identifier token whose name has already been interned as @a symbol
+			constexpr inline token(const std::string_view name, symbol_id symbol) noexcept;
+			token(const std::string&& str, token_type type) noexcept = delete;
 
 			constexpr token(const token&) noexcept = default;
 			constexpr token(token&&) noexcept = default;
@@ -133,104 +129,114 @@ namespace shift {
 			constexpr token& operator=(const token&) noexcept = default;
 			constexpr token& operator=(token&&) noexcept = default;
 
-			constexpr inline bool operator==(const token& other) const noexcept { return this->m_type == other.m_type && this->m_index == other.m_index && this->m_data == other.m_data; }
-			constexpr inline bool operator==(const std::string_view other) const noexcept { return this->m_data == other; }
-			inline bool operator==(const std::string& other) const noexcept { return this->m_data == other; }
+			constexpr inline bool operator==(const token& other) const noexcept { return this->m_type == other.m_type && this->m_data == other.m_data && this->get_data().length() == other.get_data().length(); }
+			constexpr inline bool operator==(const std::string_view other) const noexcept { return this->get_data() == other; }
+			inline bool operator==(const std::string& other) const noexcept { return this->get_data() == other; }
 
 			constexpr inline bool operator!=(const token& other) const noexcept { return !this->operator ==(other); }
 			constexpr inline bool operator!=(const std::string_view& other) const noexcept { return !this->operator ==(other); }
 			inline bool operator!=(const std::string& other) const noexcept { return !this->operator ==(std::string_view(other.c_str(), other.length())); }
 
-			constexpr inline bool operator>(const token& other) const noexcept { return this->m_index > other.m_index; }
-			constexpr inline bool operator<(const token& other) const noexcept { return this->m_index < other.m_index; }
+			// Tokens of the same file are ordered by their position within the source
+			constexpr inline bool operator>(const token& other) const noexcept { return this->m_data > other.m_data; }
+			constexpr inline bool operator<(const token& other) const noexcept { return this->m_data < other.m_data; }
 
-			constexpr inline std::string_view get_data(void) const noexcept { return this->m_data; }
+			constexpr inline std::string_view get_data(void) const noexcept { return std::string_view(this->m_data, this->is_identifier() ? this->m_name_length : this->m_length); }
 
-			constexpr inline file_indexer get_file_index(void) const noexcept { return this->m_index; }
+			/// Line and column of this token, derived from the line table of its source (0:0 if the token is not part of a source file)
+			inline file_indexer get_file_index(void) const noexcept { return source_map::locate(this->m_data); }
 
-			constexpr inline token_type get_token_type(void) const noexcept { return this->m_type; }
+			constexpr inline token_type get_token_type(void) const noexcept { return token_type(this->m_type); }
 
-			constexpr inline operator std::string_view(void) const noexcept { return this->m_data; }
+			/// Interned name of an identifier, interned once at construction; symbols::none for any other token
+			constexpr inline symbol_id get_symbol(void) const noexcept { return this->is_identifier() ? this->m_symbol : symbols::none; }
 
-			constexpr inline operator token_type(void) const noexcept { return this->m_type; }
+			/// Keyword ID, derived from the symbol ID; KW_NONE for anything that is not a keyword identifier
+			constexpr inline keywords::keyword_type get_keyword(void) const noexcept { return symbols::keyword(this->get_symbol()); }
+
+			/**
+			 * Decoded value of this literal, looked up in the literal table of its source (like get_file_index()).
+			 * @return The literal, or nullptr if this is not a literal token of a tokenized source file.
+			 */
+			inline const literal* get_literal(void) const noexcept;
 
-			constexpr inline operator file_indexer(void) const noexcept { return this->m_index; }
+			constexpr inline operator std::string_view(void) const noexcept { return this->get_data(); }
 
-			constexpr inline bool is_null(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "null")); }
+			constexpr inline operator token_type(void) const noexcept { return this->get_token_type(); }
 
-			constexpr inline bool is_module(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "module")); }
+			inline operator file_indexer(void) const noexcept { return this->get_file_index(); }
+
+			constexpr inline bool is_null(void) const noexcept { return this->get_keyword() == keywords::KW_NULL; }
+
+			constexpr inline bool is_module(void) const noexcept { return this->get_keyword() == keywords::KW_MODULE; }
 
 			// unsused
-			constexpr inline bool is_namespace(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "namespace")); }
+			constexpr inline bool is_namespace(void) const noexcept { return this->get_keyword() == keywords::KW_NAMESPACE; }
 
-			constexpr inline bool is_const(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "const")); }
+			constexpr inline bool is_const(void) const noexcept { return this->get_keyword() == keywords::KW_CONST; }
 
-			constexpr inline bool is_public(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "public")); }
+			constexpr inline bool is_public(void) const noexcept { return this->get_keyword() == keywords::KW_PUBLIC; }
 
-			constexpr inline bool is_protected(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "protected")); }
+			constexpr inline bool is_protected(void) const noexcept { return this->get_keyword() == keywords::KW_PROTECTED; }
 
-			constexpr inline bool is_private(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "private")); }
+			constexpr inline bool is_private(void) const noexcept { return this->get_keyword() == keywords::KW_PRIVATE; }
 
-			constexpr inline bool is_static(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "static")); }
+			constexpr inline bool is_static(void) const noexcept { return this->get_keyword() == keywords::KW_STATIC; }
 
 			// currently unused
-			constexpr inline bool is_binary(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "binary")); }
+			constexpr inline bool is_binary(void) const noexcept { return this->get_keyword() == keywords::KW_BINARY; }
 
 			// constexpr inline bool is_floating_point_literal(void) const noexcept {	return (this->m_type == FLOATING_POINT_LITERAL);}
 
-			constexpr inline bool is_void(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "void")); }
+			constexpr inline bool is_void(void) const noexcept { return this->get_keyword() == keywords::KW_VOID; }
 
 			// unsused
-			constexpr inline bool is_req(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "req")); }
+			constexpr inline bool is_req(void) const noexcept { return this->get_keyword() == keywords::KW_REQ; }
 
-			constexpr inline bool is_use(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "use")); }
+			constexpr inline bool is_use(void) const noexcept { return this->get_keyword() == keywords::KW_USE; }
 
 			// currently unused
-			constexpr inline bool is_unsafe(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "unsafe")); }
+			constexpr inline bool is_unsafe(void) const noexcept { return this->get_keyword() == keywords::KW_UNSAFE; }
 
-			constexpr inline bool is_extern(void) const noexcept { return ((this->is_identifier()) && (this->m_data == "extern" || this->m_data == "ext")); }
+			constexpr inline bool is_extern(void) const noexcept { return keywords::is_any(this->get_keyword(), keywords::EXTERN); }
 
-			constexpr inline bool is_class(void) const noexcept { return (this->is_identifier()) && (this->m_data == "class"); }
+			constexpr inline bool is_class(void) const noexcept { return this->get_keyword() == keywords::KW_CLASS; }
 
-			constexpr inline bool is_init(void) const noexcept { return (this->is_identifier()) && (this->m_data == "init"); }
+			constexpr inline bool is_init(void) const noexcept { return this->get_keyword() == keywords::KW_INIT; }
 
-			constexpr inline bool is_operator(void) const noexcept { return (this->is_identifier()) && (this->m_data == "operator"); }
+			constexpr inline bool is_operator(void) const noexcept { return this->get_keyword() == keywords::KW_OPERATOR; }
 
-			constexpr inline bool is_constructor(void) const noexcept { return (this->is_identifier()) && (this->m_data == "constructor"); }
+			constexpr inline bool is_constructor(void) const noexcept { return this->get_keyword() == keywords::KW_CONSTRUCTOR; }
 
-			constexpr inline bool is_destructor(void) const noexcept { return (this->is_identifier()) && (this->m_data == "destructor"); }
+			constexpr inline bool is_destructor(void) const noexcept { return this->get_keyword() == keywords::KW_DESTRUCTOR; }
 
-			constexpr inline bool is_if(void) const noexcept { return (this->is_identifier()) && (this->m_data == "if"); }
+			constexpr inline bool is_if(void) const noexcept { return this->get_keyword() == keywords::KW_IF; }
 
-			constexpr inline bool is_else(void) const noexcept { return (this->is_identifier()) && (this->m_data == "else"); }
+			constexpr inline bool is_else(void) const noexcept { return this->get_keyword() == keywords::KW_ELSE; }
 
-			constexpr inline bool is_while(void) const noexcept { return (this->is_identifier()) && (this->m_data == "while"); }
+			constexpr inline bool is_while(void) const noexcept { return this->get_keyword() == keywords::KW_WHILE; }
 
-			constexpr inline bool is_do(void) const noexcept { return (this->is_identifier()) && (this->m_data == "do"); }
+			constexpr inline bool is_do(void) const noexcept { return this->get_keyword() == keywords::KW_DO; }
 
-			constexpr inline bool is_return(void) const noexcept { return (this->is_identifier()) && (this->m_data == "return"); }
+			constexpr inline bool is_return(void) const noexcept { return this->get_keyword() == keywords::KW_RETURN; }
 
-			constexpr inline bool is_continue(void) const noexcept { return (this->is_identifier()) && (this->m_data == "continue"); }
+			constexpr inline bool is_continue(void) const noexcept { return this->get_keyword() == keywords::KW_CONTINUE; }
 
-			constexpr inline bool is_break(void) const noexcept { return (this->is_identifier()) && (this->m_data == "break"); }
+			constexpr inline bool is_break(void) const noexcept { return this->get_keyword() == keywords::KW_BREAK; }
 
-			constexpr inline bool is_for(void) const noexcept { return (this->is_identifier()) && (this->m_data == "for"); }
+			constexpr inline bool is_for(void) const noexcept { return this->get_keyword() == keywords::KW_FOR; }
 
 			constexpr inline bool is_valid_class_name(void) const noexcept { return (this->is_identifier()) && (!this->is_keyword()); }
 
-			constexpr inline bool is_this(void) const noexcept { return (this->is_identifier()) && (this->m_data == "this"); }
+			constexpr inline bool is_this(void) const noexcept { return this->get_keyword() == keywords::KW_THIS; }
 
-			constexpr inline bool is_base(void) const noexcept { return (this->is_identifier()) && (this->m_data == "base"); }
+			constexpr inline bool is_base(void) const noexcept { return this->get_keyword() == keywords::KW_BASE; }
 
-			constexpr inline bool is_new(void) const noexcept { return (this->is_identifier()) && (this->m_data == "new"); }
+			constexpr inline bool is_new(void) const noexcept { return this->get_keyword() == keywords::KW_NEW; }
 
-			constexpr inline bool is_throw(void) const noexcept { return (this->is_identifier()) && (this->m_data == "throw"); }
+			constexpr inline bool is_throw(void) const noexcept { return this->get_keyword() == keywords::KW_THROW; }
 
-			constexpr inline bool is_access_specifier(void) const noexcept {
-				return (this->is_identifier())
-					&& (this->is_public() || this->is_protected() || this->is_private() || this->is_static() || this->is_extern() || this->is_binary()
-						|| this->is_const() || this->is_unsafe());
-			}
+			constexpr inline bool is_access_specifier(void) const noexcept { return keywords::is_any(this->get_keyword(), keywords::ACCESS_SPECIFIERS); }
 
 			constexpr inline bool is_overload_operator(void) const noexcept { return this->is_prefix_overload_operator() || this->is_suffix_overload_operator(); }
 
@@ -278,22 +284,15 @@ namespace shift {
 
 			constexpr inline bool is_literal(void) const noexcept { return this->is_string_literal() || this->is_number_literal() || this->is_char_literal(); }
 
-			constexpr inline bool is_keyword(void) const noexcept {
-				return (this->is_identifier())
-					&& (this->is_binary() || this->is_const() || this->is_extern() || this->is_module() || this->is_namespace() || this->is_private()
-						|| this->is_protected() || this->is_public() || this->is_req() || this->is_unsafe() || this->is_use() || this->is_void()
-						|| this->is_class() || this->is_init() || this->is_operator() || this->is_constructor() || this->is_destructor()
-						|| this->is_this() || this->is_base() || this->is_if() || this->is_else() || this->is_while() || this->is_do() || this->is_return() 
-						|| this->is_continue() || this->is_break() || this->is_for() || this->is_true() || this->is_false() || this->is_access_specifier());
-			}
+			constexpr inline bool is_keyword(void) const noexcept { return keywords::is_any(this->get_keyword(), keywords::RESERVED); }
 
-			constexpr inline bool is_alias(void) const noexcept { return (this->is_identifier()) && (this->m_data == "alias"); }
+			constexpr inline bool is_alias(void) const noexcept { return this->get_keyword() == keywords::KW_ALIAS; }
 
-			constexpr inline bool is_true(void) const noexcept { return (this->is_identifier()) && (this->m_data == "true"); }
+			constexpr inline bool is_true(void) const noexcept { return this->get_keyword() == keywords::KW_TRUE; }
 
-			constexpr inline bool is_false(void) const noexcept { return (this->is_identifier()) && (this->m_data == "false"); }
+			constexpr inline bool is_false(void) const noexcept { return this->get_keyword() == keywords::KW_FALSE; }
 
-			constexpr inline bool is_asm(void) const noexcept { return (this->is_identifier()) && (this->m_data == "asm" || this->m_data == "_asm_" || this->m_data == "__asm__"); }
+			constexpr inline bool is_asm(void) const noexcept { return keywords::is_any(this->get_keyword(), keywords::ASM); }
 
 			// whether this token can be found in assembly (i.e. compatible with asm blocks)
 			constexpr inline bool is_asm_compatible(void) const noexcept {
@@ -357,18 +356,40 @@ namespace shift {
 			constexpr inline bool is_null_token(void) const noexcept { return (this->m_type == NULL_TOKEN); }
 
 		private:
-			std::string_view m_data;
-			token_type m_type = NULL_TOKEN;
-			file_indexer m_index;
+			const char* m_data = nullptr; // points into the (mapped) source of the token
+			union {
+				std::uint32_t m_length = 0; // every token but identifiers
+				symbol_id m_symbol; // identifiers, whose length is m_name_length instead
+			};
+			std::uint16_t m_type = NULL_TOKEN;
+			std::uint16_t m_name_length = 0;
 		};
 
+		static_assert(sizeof(token) <= 16, "tokens are expected to be packed into 16 bytes");
+
 		inline constexpr token token::null = token();
 
-		inline token::token(const std::string& str, const token_type type, const file_indexer index) noexcept: m_data(str.c_str(),
-			str.length()), m_type(type), m_index(index) {}
+		inline token::token(const std::string& str, const token_type type) noexcept: token(std::string_view(str.c_str(), str.length()), type) {}
 
-		constexpr inline token::token(const std::string_view str, const token_type type, const file_indexer index) noexcept: m_data(str), m_type(
-			type), m_index(index) {}
+		constexpr inline token::token(const std::string_view str, const token_type type) noexcept: m_data(str.data()), m_type(static_cast<std::uint16_t>(type)) {
+			if (type == IDENTIFIER) { // identifiers are never constant expressions, they must be interned
+				const std::string_view name = str.substr(0, max_identifier_length);
+				this->m_symbol = symbols::intern(name);
+				this->m_name_length = static_cast<std::uint16_t>(name.length());
+			} else {
+				this->m_length = static_cast<std::uint32_t>(str.length());
+			}
+		}
+
+		constexpr inline token::token(const std::string_view name, const symbol_id symbol) noexcept: m_data(name.data()), m_symbol(symbol),
+			m_type(IDENTIFIER), m_name_length(static_cast<std::uint16_t>(std::min(name.length(), max_identifier_length))) {}
+
+		inline const literal* token::get_literal(void) const noexcept {
+			const source_map* const map = source_map::find(this->m_data);
+			return map ? map->literals().find(map->offset(this->m_data)) : nullptr;
+		}
+
+		class token_cache;
 
 		class tokenizer {
 		public:
@@ -380,7 +401,76 @@ namespace shift {
 			tokenizer& operator=(const tokenizer&) = default;
 			tokenizer& operator=(tokenizer&&) noexcept = default;
 
+			/// Minimum number of bytes lexed by each thread of tokenize(); smaller files are lexed on the calling thread
+			static constexpr size_t parallel_chunk_size = size_t(1) << 20;
+
+			/// Number of bytes past the end of a token the lexer may look at before deciding where the token ends
+			static constexpr size_t max_lookahead = 4;
+
+			/// Tokens replaced by edit(): [begin, begin + removed) of the old token list became [begin, begin + inserted)
+			struct token_range {
+				size_t begin = 0, removed = 0, inserted = 0;
+			};
+
+			/**
+			 * Lexes the whole file into the token list of this tokenizer.
+			 *
+			 * Large files are split into chunks at line starts, which are lexed concurrently, assuming that none of them
+			 * starts inside a comment or a literal. The chunks are then stitched together in order: wherever the previous
+			 * chunk actually ended past the start of the next one, the next one is re-lexed from there until it lines up
+			 * again with what was lexed speculatively. The tokens and diagnostics are the same as those of a serial run.
+			 *
+			 * With a cache (see set_cache()), files that were lexed before are loaded from it instead.
+			 *
+			 * Lexing stops early once the error handler has reached its error limit (see error_handler::set_max_errors()).
+			 */
 			void tokenize(void);
+
+			/**
+			 * Edits the source of a tokenized file, and lexes again only what the edit could have changed.
+			 *
+			 * Lexing restarts at the first token whose lookahead (see max_lookahead) reaches the edit, and stops as soon
+			 * as a token starts past the inserted text where a token of the old list started too, as the lexer carries
+			 * nothing from one token to the next but its position. The tokens before the restart stay, those after the
+			 * point where both lists meet are moved by the size difference of the edit, and the line table and literals of
+			 * the source are updated to match. Only the re-lexed tokens are diagnosed again, but those before the edit that
+			 * came out the same are not counted as replaced.
+			 *
+			 * The source moves to a buffer of its own, so tokens of copies of this tokenizer are invalidated, and the
+			 * position of the tokenizer is kept as an index but its marks are dropped.
+			 * @param[in] offset The byte offset of the edit in the source.
+			 * @param[in] removed The number of bytes removed at @a offset.
+			 * @param[in] inserted The text inserted at @a offset.
+			 * @return The tokens that were replaced; nothing is changed (and an empty range returned) if the file was not
+			 * completely tokenized with tokenize(), if @a offset is past the end of the source, or if the edited source
+			 * would be too large.
+			 */
+			token_range edit(size_t offset, size_t removed, std::string_view inserted);
+
+			/**
+			 * Maps the file and prepares it for lexing with lex(), discarding any previous tokens.
+			 * @return True if the file could be opened, false otherwise.
+			 */
+			bool open(void);
+
+			/**
+			 * Lexes up to @a count more tokens of the file opened by open(), resuming where the previous call stopped.
+			 * The tokens are appended to @a out rather than to the token list of this tokenizer.
+			 * @return The number of tokens appended; 0 once the whole file has been lexed.
+			 */
+			size_t lex(std::vector<token>& out, size_t count);
+
+			/// Whether lex() has consumed the whole file
+			inline bool is_lexed(void) const noexcept { return !this->m_lex_state.open || this->m_lex_state.index >= this->m_filedata.size(); }
+
+			/// Maximum number of threads used by tokenize(); 0 (the default) uses one per hardware thread
+			inline void set_threads(const size_t threads) noexcept { this->m_threads = threads; }
+			inline size_t get_threads(void) const noexcept { return this->m_threads; }
+
+			/// Cache consulted by tokenize() before lexing, and filled by it after lexing; nullptr (the default) disables caching
+			inline void set_cache(const token_cache* const cache) noexcept { this->m_cache = cache; }
+			inline const token_cache* get_cache(void) const noexcept { return this->m_cache; }
+
 			inline void mark(void) noexcept { return this->m_token_marks.push(this->m_token_index); }
 			void rollback(void) noexcept;
 			inline void pop_mark() noexcept { return pop_marks(1); }
@@ -413,13 +503,19 @@ namespace shift {
 
 			inline const token& token_after(typename std::vector<token>::const_iterator it) const noexcept { return it == this->m_tokens.cend() ? token::null : token_at(++it); }
 
-			inline const token& token_before(const token& token) const noexcept { return this->token_before(token.get_file_index()); }
+			const token& token_before(const token& token) const noexcept;
 
-			inline const token& token_before(const token* const token) const noexcept { return this->token_before(token->get_file_index()); }
+			inline const token& token_before(const token* const token) const noexcept { return this->token_before(*token); }
 
 			inline const filesystem::file& get_file(void) const noexcept { return m_file; }
 
-			inline const std::vector<std::string_view>& get_lines(void) const noexcept { return this->m_lines; }
+			/// Retrieves a line of the file, without its line terminator (lines start at 1)
+			inline std::string_view get_line(const size_t line) const noexcept { return this->m_source ? this->m_source->line(line) : std::string_view(); }
+
+			inline size_t get_line_count(void) const noexcept { return this->m_source ? this->m_source->line_count() : 0; }
+
+			inline const source_map* get_source_map(void) const noexcept { return this->m_source.get(); }
+			inline std::shared_ptr<const source_map> get_shared_source_map(void) const noexcept { return this->m_source; }
 
 			inline const std::vector<token>& get_tokens(void) const noexcept { return this->m_tokens; }
 
@@ -428,14 +524,32 @@ namespace shift {
 			inline const error_handler* get_error_handler() const noexcept { return m_error_handler; }
 
 			inline void set_error_handler(error_handler* const error_handler) noexcept { m_error_handler = error_handler; }
+		private:
+			/// Where lex() resumes from
+			struct lex_state {
+				size_t index = 0, line = 1, col = 1, last_line = 0;
+				bool open = false;
+			};
+		private:
+			std::size_t m_find_token(const file_indexer index) const noexcept;
+			std::size_t m_find_token(const token& token) const noexcept;
+			const token& m_token_before(const std::size_t index) const noexcept;
+			const token& m_token_after(const std::size_t index) const noexcept;
+			size_t m_lex(std::vector<token>& out, size_t count, size_t stop);
+			void m_decode_literals(typename std::vector<token>::const_iterator begin, typename std::vector<token>::const_iterator end);
+			void m_lex_parallel(size_t threads);
+			lex_state m_lex_state_at(size_t index) const noexcept;
 		protected:
 			error_handler* m_error_handler;
 			filesystem::file m_file;
-			std::string m_filedata;
-			std::vector<std::string_view> m_lines;
+			std::shared_ptr<source_map> m_source; // shared between copies, so their tokens stay valid
+			std::string_view m_filedata; // read-only view over m_source
 			std::vector<token> m_tokens;
 			std::stack<typename std::vector<token>::const_iterator> m_token_marks;
 			typename std::vector<token>::const_iterator m_token_index;
+			lex_state m_lex_state;
+			size_t m_threads = 0;
+			const token_cache* m_cache = nullptr;
 		};
 
 		inline tokenizer::tokenizer(error_handler* const handler, const filesystem::file& file): m_error_handler(handler),
@@ -0,0 +1,146 @@
+#include "filesystem/mapped_file.h"
+
+#include <cstring>
+#include <fstream>
+
+#ifdef SHIFT_SUBSYSTEM_WINDOWS
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace shift {
+	namespace filesystem {
+		static std::size_t page_size(void) noexcept {
+#ifdef SHIFT_SUBSYSTEM_WINDOWS
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return static_cast<std::size_t>(info.dwPageSize);
+#else
+			const long size = sysconf(_SC_PAGESIZE);
+			return size > 0 ? static_cast<std::size_t>(size) : std::size_t(4096);
+#endif
+		}
+
+		// The kernel zero-fills the remainder of the last mapped page, which we use as our padding
+		static bool has_mapping_padding(const std::size_t size) noexcept {
+			const std::size_t tail = size % page_size();
+			return tail != 0 && (page_size() - tail) >= mapped_file::padding;
+		}
+
+		mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+			if (this == &other)
+				return *this;
+
+			this->close();
+
+			this->m_data = other.m_data;
+			this->m_size = other.m_size;
+			this->m_mapping = other.m_mapping;
+			this->m_mapping_size = other.m_mapping_size;
+			this->m_buffer = std::move(other.m_buffer);
+
+			other.m_data = nullptr;
+			other.m_size = 0;
+			other.m_mapping = nullptr;
+			other.m_mapping_size = 0;
+			return *this;
+		}
+
+		bool mapped_file::open(const file& file) noexcept {
+			this->close();
+
+			std::uintmax_t size;
+			try {
+				size = file.size();
+			}
+			catch (...) {
+				return false;
+			}
+
+			// Nothing to map; an empty (but padded) buffer still allows scanners to read their sentinel
+			if (size == 0 || !has_mapping_padding(static_cast<std::size_t>(size)))
+				return this->m_read(file);
+
+#ifdef SHIFT_SUBSYSTEM_WINDOWS
+			const HANDLE handle = CreateFileW(file.raw_path().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle == INVALID_HANDLE_VALUE)
+				return this->m_read(file);
+
+			const HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(handle);
+			if (!mapping)
+				return this->m_read(file);
+
+			// The view keeps the mapping object alive, so the handle can be released right away
+			void* const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+			if (!view)
+				return this->m_read(file);
+#else
+			const int fd = ::open(file.raw_path().c_str(), O_RDONLY);
+			if (fd < 0)
+				return this->m_read(file);
+
+			void* const view = ::mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (view == MAP_FAILED)
+				return this->m_read(file);
+
+#	ifdef POSIX_MADV_SEQUENTIAL
+			::posix_madvise(view, static_cast<std::size_t>(size), POSIX_MADV_SEQUENTIAL);
+#	endif
+#endif
+			this->m_mapping = view;
+			this->m_mapping_size = static_cast<std::size_t>(size);
+			this->m_data = static_cast<const char*>(view);
+			this->m_size = static_cast<std::size_t>(size);
+			return true;
+		}
+
+		void mapped_file::close(void) noexcept {
+			if (this->m_mapping) {
+#ifdef SHIFT_SUBSYSTEM_WINDOWS
+				UnmapViewOfFile(this->m_mapping);
+#else
+				::munmap(this->m_mapping, this->m_mapping_size);
+#endif
+			}
+
+			this->m_buffer.reset();
+			this->m_mapping = nullptr;
+			this->m_mapping_size = 0;
+			this->m_data = nullptr;
+			this->m_size = 0;
+		}
+
+		bool mapped_file::m_read(const file& file) noexcept {
+			try {
+				std::ifstream input_file(file.raw_path(), std::ios_base::in | std::ios_base::binary);
+				if (!input_file)
+					return false;
+
+				std::uintmax_t size = 0;
+				try {
+					size = file.size();
+				}
+				catch (...) {}
+
+				this->m_buffer.reset(new char[static_cast<std::size_t>(size) + padding]);
+				input_file.read(this->m_buffer.get(), static_cast<std::streamsize>(size));
+
+				this->m_size = static_cast<std::size_t>(input_file.gcount()); // the file may have shrunk since its size was queried
+				std::memset(this->m_buffer.get() + this->m_size, 0, static_cast<std::size_t>(size) + padding - this->m_size);
+				this->m_data = this->m_buffer.get();
+				return true;
+			}
+			catch (...) {
+				this->close();
+				return false;
+			}
+		}
+	}
+}
@@ -0,0 +1,88 @@
+/**
+ * @file filesystem/mapped_file.h
+ *
+ * Represents the read-only, memory-mapped contents of a file
+ */
+#ifndef SHIFT_FILESYSTEM_MAPPED_FILE_H_
+#define SHIFT_FILESYSTEM_MAPPED_FILE_H_ 1
+
+#include "shift_config.h"
+#include "filesystem/file.h"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace shift {
+	namespace filesystem {
+		/**
+		 * Read-only view over the contents of a file on disk.
+		 *
+		 * The file is memory-mapped whenever possible, so that its bytes are never copied into the process.
+		 * Every view is followed by at least @a padding zero bytes, which allows scanners to peek (or read whole
+		 * blocks) past the end of the data without bounds checks. When a mapping cannot guarantee that padding
+		 * (i.e. the file ends too close to a page boundary), or when mapping fails, the file is read once into a
+		 * padded heap buffer instead.
+		 */
+		class mapped_file {
+		public:
+			/// Number of zero bytes guaranteed to follow the data
+			static constexpr std::size_t padding = 64;
+		public:
+			mapped_file() noexcept = default;
+			inline mapped_file(const file& file);
+			mapped_file(const mapped_file&) = delete;
+			inline mapped_file(mapped_file&&) noexcept;
+			inline ~mapped_file() noexcept { close(); }
+
+			mapped_file& operator=(const mapped_file&) = delete;
+			mapped_file& operator=(mapped_file&&) noexcept;
+
+			/**
+			 * Opens and maps the specified file, releasing any previously opened file.
+			 * @param[in] file The file to map.
+			 * @return True if the file contents are now available, false otherwise.
+			 */
+			bool open(const file& file) noexcept;
+
+			/**
+			 * Releases the mapping (or buffer) held by this object.
+			 */
+			void close(void) noexcept;
+
+			inline const char* data(void) const noexcept { return this->m_data; }
+			inline std::size_t size(void) const noexcept { return this->m_size; }
+			inline bool empty(void) const noexcept { return this->m_size == 0; }
+			inline std::string_view view(void) const noexcept { return std::string_view(this->m_data, this->m_size); }
+
+			/// Whether the contents are backed by a memory mapping, as opposed to a heap buffer
+			inline bool is_mapped(void) const noexcept { return this->m_mapping != nullptr; }
+			inline bool is_open(void) const noexcept { return this->m_data != nullptr; }
+			inline explicit operator bool(void) const noexcept { return this->is_open(); }
+		private:
+			bool m_read(const file& file) noexcept;
+		private:
+			const char* m_data = nullptr;
+			std::size_t m_size = 0;
+
+			/// Base address and length of the mapping, if any
+			void* m_mapping = nullptr;
+			std::size_t m_mapping_size = 0;
+
+			/// Fallback storage, used when the file could not be mapped with enough trailing padding
+			std::unique_ptr<char[]> m_buffer;
+		};
+
+		inline mapped_file::mapped_file(const file& file) { open(file); }
+
+		inline mapped_file::mapped_file(mapped_file&& other) noexcept: m_data(other.m_data), m_size(other.m_size), m_mapping(other.m_mapping),
+			m_mapping_size(other.m_mapping_size), m_buffer(std::move(other.m_buffer)) {
+			other.m_data = nullptr;
+			other.m_size = 0;
+			other.m_mapping = nullptr;
+			other.m_mapping_size = 0;
+		}
+	}
+}
+
+#endif /* SHIFT_FILESYSTEM_MAPPED_FILE_H_ */
@@ -15,6 +15,7 @@ int main() {
         comp.parse_flags();
         comp.tokenize();
         comp.parse();
+        comp.emit_modules();
         comp.get_error_handler().print_clear();
     }
     shift::logging::disable_colored_console();